@@ -0,0 +1,185 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * Benchmark helpers for host builds
+ *
+ * - `measure()` times a function on the host clock, in the style of Google Benchmark: the function is called until
+ *   `minSeconds` have passed, and the time per item is reported.
+ * - `BenchSerial` is a serial interface without timing model or locks, so the measured time is spent in the library.
+ *   It can replay a byte pattern endlessly to keep the receiver busy.
+ * - `connect()` runs a scripted LPF2 handshake on the virtual clock.
+ *
+ * Include `host/LumpHost.h` before this header.
+ */
+
+#ifndef LUMP_BENCH_H
+#define LUMP_BENCH_H
+
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+
+namespace LumpBench {
+
+  /* Prevents the compiler from optimizing a value away. */
+  template <typename V>
+  inline void doNotOptimize(V const &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+  }
+
+  inline double nowSeconds() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+  }
+
+  /**
+   * Times a function.
+   *
+   * @tparam F Type of the function. Returns the number of items processed by the call.
+   * @param func Function.
+   * @param minSeconds Minimum total time.
+   * @return Time per item in nanoseconds.
+   */
+  template <typename F>
+  double measure(F func, double minSeconds = 0.2) {
+    uint64_t items = 0;
+    double start   = nowSeconds();
+    double elapsed = 0;
+    do {
+      for (int i = 0; i < 64; ++i) {
+        items += func();
+      }
+      elapsed = nowSeconds() - start;
+    } while (elapsed < minSeconds);
+    return items ? elapsed * 1e9 / items : 0;
+  }
+
+  /* Prints a result row. */
+  inline void report(const char *name, double value, const char *unit) { printf("%-44s %12.1f %s\n", name, value, unit); }
+
+  /* Prints a table header. */
+  inline void header(const char *title) {
+    printf("\n%s\n", title);
+    for (int i = 0; title[i]; ++i) {
+      putchar('-');
+    }
+    putchar('\n');
+  }
+
+  class BenchSerial {
+    public:
+      void begin(uint32_t baud) { speed = baud; }
+      void end() {}
+
+      int available() {
+        if (repeat && !rx.empty()) {
+          return 256;
+        }
+        return static_cast<int>(rx.size() - rxIdx);
+      }
+
+      int read() {
+        if (rxIdx == rx.size()) {
+          if (!repeat || rx.empty()) {
+            return -1;
+          }
+          rxIdx = 0;
+        }
+        ++rxBytes;
+        return rx[rxIdx++];
+      }
+
+      size_t write(uint8_t c) {
+        ++txBytes;
+        return 1;
+      }
+
+      size_t write(const uint8_t *buffer, size_t size) {
+        txBytes += size;
+        return size;
+      }
+
+      int availableForWrite() { return 256; }
+      void flush() {}
+
+      /**
+       * Sets the bytes to receive.
+       *
+       * @param bytes Bytes.
+       * @param repeatBytes Whether to replay the bytes endlessly.
+       */
+      void feed(std::vector<uint8_t> bytes, bool repeatBytes = false) {
+        rx     = bytes;
+        rxIdx  = 0;
+        repeat = repeatBytes;
+      }
+
+      uint32_t speed{0};
+      uint64_t rxBytes{0};
+      uint64_t txBytes{0};
+
+    private:
+      std::vector<uint8_t> rx;
+      size_t rxIdx{0};
+      bool repeat{false};
+  };
+
+  /**
+   * Builds a message as sent by the host.
+   *
+   * @param type Message type.
+   * @param cmd Command or mode.
+   * @param payload Payload (1, 2, 4, ... bytes).
+   * @return Message.
+   */
+  inline std::vector<uint8_t> hostMsg(uint8_t type, uint8_t cmd, std::vector<uint8_t> payload) {
+    std::vector<uint8_t> msg;
+    msg.push_back(LumpDeviceBuilder::Internal::encMsgHeader(type, payload.size(), cmd));
+    msg.insert(msg.end(), payload.begin(), payload.end());
+    msg.push_back(LumpDeviceBuilder::Internal::calcChecksum(msg.data(), msg.size()));
+    return msg;
+  }
+
+  /**
+   * Runs a scripted LPF2 handshake on the virtual clock.
+   *
+   * @tparam D Type of the device.
+   * @param device Device, which must use `BenchSerial`.
+   * @param serial Serial interface of the device.
+   * @param runNanos Adds the host time spent in `run()`, if not `nullptr`.
+   * @param runCalls Adds the number of `run()` calls, if not `nullptr`.
+   * @return `true` if the device is communicating.
+   */
+  template <typename D>
+  bool connect(D &device, BenchSerial &serial, double *runNanos = nullptr, uint64_t *runCalls = nullptr) {
+    device.begin();
+
+    bool speedSent = false;
+    bool ackSent   = false;
+    for (int i = 0; i < 100000 && device.state() != LumpDeviceState::Communicating; ++i) {
+      if (!speedSent && device.state() == LumpDeviceState::WaitingAutoId) {
+        serial.feed(hostMsg(LUMP_MSG_TYPE_CMD, LUMP_CMD_SPEED, {0x00, 0xc2, 0x01, 0x00}));
+        speedSent = true;
+      } else if (!ackSent && device.state() == LumpDeviceState::WaitingAckReply) {
+        serial.feed({LUMP_SYS_ACK});
+        ackSent = true;
+      }
+
+      double start = nowSeconds();
+      device.run();
+      if (runNanos) {
+        *runNanos += (nowSeconds() - start) * 1e9;
+      }
+      if (runCalls) {
+        ++*runCalls;
+      }
+      LumpHost::advance(100);
+    }
+    return device.state() == LumpDeviceState::Communicating;
+  }
+
+} // namespace LumpBench
+
+#endif // LUMP_BENCH_H
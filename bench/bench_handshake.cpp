@@ -0,0 +1,149 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * Worst-case `run()` latency during an EV3 handshake
+ *
+ * An EV3 host never sends `LUMP_CMD_SPEED`, so the whole handshake goes out at 2400 baud and the information of one
+ * mode takes several hundred milliseconds to send. `run()` is called every 100 us of virtual time until the device is
+ * communicating. Reports the longest single `run()`:
+ * - _device_: virtual time spent in the call, i.e., the time the mock UART blocked in `write()` or `flush()`.
+ *   This is what the sketch loop sees on an MCU.
+ * - _host_: host time of the call. The handshake is repeated `repeats` times and the smallest maximum is reported,
+ *   which filters out preemptions of the host.
+ *
+ * With the handshake image (when the library has it), the device reconnects once and the replayed handshake is
+ * measured as well. The image serialized at compile time (when the library has it) is measured on the first handshake.
+ */
+
+#include "host/LumpHost.h"
+
+#include "LumpBench.h"
+
+using namespace LumpBench;
+using LumpHost::HostEmulator;
+using LumpHost::MockSerial;
+
+static const uint32_t loopMicros = 100;
+static const uint8_t repeats     = 5;
+
+static LumpMode modes[]{
+    {"Float 0", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+    {"Float 1", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+    {"Float 2", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+    {"Float 3", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+    {"Float 4", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+    {"Float 5", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+    {"Float 6", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+    {"Float 7", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+};
+
+#ifdef LUMP_HANDSHAKE_IMAGE
+static constexpr LumpMode flashModes[]{
+    {"Float 0", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+    {"Float 1", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+    {"Float 2", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+    {"Float 3", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+    {"Float 4", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+    {"Float 5", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+    {"Float 6", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+    {"Float 7", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+};
+
+LUMP_HANDSHAKE_IMAGE(flashImage, 68, 57600, LUMP_VIEW_ALL, flashModes);
+#endif
+
+struct Latency {
+    double handshakeMillis{0};
+    uint64_t runs{0};
+    uint64_t maxDeviceMicros{0};
+    double maxHostMicros{0};
+};
+
+/* Runs the device until it is communicating, and records the longest `run()`. */
+static Latency handshake(LumpDevice<MockSerial> &device, HostEmulator &host) {
+  Latency latency;
+  uint64_t start = LumpHost::clock().load();
+  uint64_t end   = start + 30000000;
+
+  while (device.state() != LumpDeviceState::Communicating && LumpHost::clock().load() < end) {
+    host.step();
+
+    uint64_t deviceStart  = LumpHost::clock().load();
+    double hostStart      = nowSeconds();
+    device.run();
+    double hostMicros     = (nowSeconds() - hostStart) * 1e6;
+    uint64_t deviceMicros = LumpHost::clock().load() - deviceStart;
+
+    latency.maxDeviceMicros = std::max(latency.maxDeviceMicros, deviceMicros);
+    latency.maxHostMicros   = std::max(latency.maxHostMicros, hostMicros);
+    ++latency.runs;
+    LumpHost::advance(loopMicros);
+  }
+
+  latency.handshakeMillis = (LumpHost::clock().load() - start) / 1000.0;
+  return latency;
+}
+
+/* Measures the first handshake, or the replayed one if `image` is set. */
+static Latency simulate(uint8_t numModes, bool image, bool flash = false) {
+  LumpHost::resetClock();
+  MockSerial serial;
+  HostEmulator host(serial, HostEmulator::Kind::Ev3);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 57600, modes, numModes);
+#ifdef LUMP_HANDSHAKE_IMAGE_SIZE
+  static uint8_t buffer[LUMP_HANDSHAKE_IMAGE_SIZE(8)];
+  if (image) {
+    device.setHandshakeImage(buffer, sizeof(buffer));
+  }
+#endif
+#ifdef LUMP_HANDSHAKE_IMAGE
+  if (flash) {
+    device.setHandshakeImage(flashImage);
+  }
+#endif
+  device.begin();
+
+  Latency latency = handshake(device, host);
+  if (image) {
+    /* Reconnects. The handshake is replayed from the image. */
+    host.keepAlive = false;
+    while (device.state() == LumpDeviceState::Communicating) {
+      host.step();
+      device.run();
+      LumpHost::advance(loopMicros);
+    }
+    host.keepAlive = true;
+    latency        = handshake(device, host);
+  }
+  return latency;
+}
+
+static void row(uint8_t numModes, bool image, bool flash = false) {
+  Latency best = simulate(numModes, image, flash);
+  for (uint8_t i = 1; i < repeats; ++i) {
+    best.maxHostMicros = std::min(best.maxHostMicros, simulate(numModes, image, flash).maxHostMicros);
+  }
+
+  char name[32];
+  snprintf(name, sizeof(name), flash ? "%u modes, flash image" : image ? "%u modes, image" : "%u modes", numModes);
+  printf("%-22s %14.1f %12llu %18llu %16.1f\n", name, best.handshakeMillis, static_cast<unsigned long long>(best.runs),
+         static_cast<unsigned long long>(best.maxDeviceMicros), best.maxHostMicros);
+}
+
+int main() {
+  header("EV3 handshake at 2400 baud, run() every 100 us (longest single run())");
+  printf("%-22s %14s %12s %18s %16s\n", "", "handshake ms", "run() calls", "max device us", "max host us");
+
+  for (uint8_t numModes : {1, 2, 4, 8}) {
+    row(numModes, false);
+#ifdef LUMP_HANDSHAKE_IMAGE_SIZE
+    row(numModes, true);
+#endif
+  }
+#ifdef LUMP_HANDSHAKE_IMAGE
+  row(8, false, true);
+#endif
+  return 0;
+}
@@ -0,0 +1,177 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * Protocol hot paths
+ *
+ * - Helpers used on every frame: `calcChecksum()`, `encMsgHeader()`, `queryLog2()`, `queryNextPow2()`.
+ * - Parsing host DATA frames in `run()` and emitting DATA frames with `send()`, for every data type and payload size,
+ *   with and without extended modes.
+ * - Host time spent in `run()` for a whole LPF2 handshake, per number of modes.
+ */
+
+#include "host/LumpHost.h"
+
+#include "LumpBench.h"
+#include <memory>
+
+using namespace LumpBench;
+using LumpDeviceBuilder::Internal::calcChecksum;
+using LumpDeviceBuilder::Internal::encMsgHeader;
+using LumpDeviceBuilder::Internal::queryLog2;
+using LumpDeviceBuilder::Internal::queryNextPow2;
+
+typedef LumpDevice<BenchSerial> Device;
+
+static const struct {
+    uint8_t type;
+    uint8_t size;
+    const char *name;
+} dataTypes[]{
+    {DATA8, 1, "DATA8"},
+    {DATA16, 2, "DATA16"},
+    {DATA32, 4, "DATA32"},
+    {DATAF, 4, "DATAF"},
+};
+
+/**
+ * Builds a mode table. The mode under test is writable, the other modes fill the table up to `numModes`.
+ *
+ * @param numModes Number of modes.
+ * @param mode Index of the mode under test.
+ */
+static std::vector<LumpMode> modeTable(uint8_t numModes, uint8_t mode, uint8_t dataType, uint8_t numData) {
+  std::vector<LumpMode> modes;
+  for (uint8_t i = 0; i < numModes; ++i) {
+    if (i == mode) {
+      modes.emplace_back("Test", dataType, numData, 4, 0, "", false, false, false, LUMP_INFO_MAPPING_NONE,
+                         LUMP_INFO_MAPPING_ABS);
+    } else {
+      modes.emplace_back("Fill", DATA8, 1, 4, 0);
+    }
+  }
+  return modes;
+}
+
+static void benchHelpers() {
+  header("Helpers (ns/call)");
+
+  uint8_t frame[LUMP_UART_BUFFER_SIZE];
+  for (uint8_t i = 0; i < sizeof(frame); ++i) {
+    frame[i] = i * 37;
+  }
+
+  for (uint8_t size : {1, 2, 4, 8, 16, 32}) {
+    char name[48];
+    snprintf(name, sizeof(name), "calcChecksum/%u", size);
+    report(name, measure([&] {
+             doNotOptimize(frame);
+             doNotOptimize(calcChecksum(frame, size + 1));
+             return 1;
+           }),
+           "ns");
+  }
+
+  volatile uint8_t input = 19;
+  report("encMsgHeader", measure([&] {
+           doNotOptimize(encMsgHeader(LUMP_MSG_TYPE_DATA, input, 3));
+           return 1;
+         }),
+         "ns");
+  report("queryLog2", measure([&] {
+           doNotOptimize(queryLog2(input));
+           return 1;
+         }),
+         "ns");
+  report("queryNextPow2", measure([&] {
+           doNotOptimize(queryNextPow2(input));
+           return 1;
+         }),
+         "ns");
+}
+
+static void benchFrames(bool ext) {
+  header(ext ? "DATA frames, mode 8 (extended) (ns/frame)" : "DATA frames, mode 0 (ns/frame)");
+  printf("%-44s %12s %12s\n", "", "parse", "emit");
+
+  uint8_t numModes = ext ? LUMP_MAX_MODE + 2 : 1;
+  uint8_t mode     = ext ? LUMP_MAX_MODE + 1 : 0;
+
+  for (auto &t : dataTypes) {
+    for (uint8_t size : {1, 2, 4, 8, 16, 32}) {
+      if (size < t.size) {
+        continue;
+      }
+
+      uint8_t numData                 = size / t.size;
+      std::vector<LumpMode> modes     = modeTable(numModes, mode, t.type, numData);
+      BenchSerial serial;
+      std::unique_ptr<Device> device(new Device(&serial, 1, 2, 68, 115200, modes.data(), numModes));
+      if (!connect(*device, serial)) {
+        printf("%s/%u: handshake failed\n", t.name, size);
+        continue;
+      }
+
+      /* Parses: the host sends DATA frames back to back (each preceded by `LUMP_CMD_EXT_MODE` for mode 8). */
+      std::vector<uint8_t> stream;
+      if (ext) {
+        stream = hostMsg(LUMP_MSG_TYPE_CMD, LUMP_CMD_EXT_MODE, {LUMP_EXT_MODE_8});
+      }
+      std::vector<uint8_t> payload(size);
+      for (uint8_t i = 0; i < size; ++i) {
+        payload[i] = i;
+      }
+      std::vector<uint8_t> data = hostMsg(LUMP_MSG_TYPE_DATA, mode % (LUMP_MAX_MODE + 1), payload);
+      stream.insert(stream.end(), data.begin(), data.end());
+      serial.feed(stream, true);
+
+      double parse = stream.size() * measure([&] {
+                       uint64_t before = serial.rxBytes;
+                       device->run();
+                       return serial.rxBytes - before;
+                     });
+
+      /* Emits. */
+      serial.feed({});
+      double emit = measure([&] {
+        device->send(payload.data(), size, mode);
+        return 1;
+      });
+
+      char name[48];
+      snprintf(name, sizeof(name), "%s/%u bytes", t.name, size);
+      printf("%-44s %12.1f %12.1f\n", name, parse, emit);
+    }
+  }
+}
+
+static void benchHandshake() {
+  header("LPF2 handshake (host time in run())");
+  printf("%-44s %12s %12s\n", "", "us", "run() calls");
+
+  for (uint8_t numModes : {1, 2, 4, 8, 16}) {
+    std::vector<LumpMode> modes = modeTable(numModes, 0, DATA16, 1);
+    BenchSerial serial;
+    std::unique_ptr<Device> device(new Device(&serial, 1, 2, 68, 115200, modes.data(), numModes));
+
+    const int repeats = 50;
+    double nanos      = 0;
+    uint64_t calls    = 0;
+    for (int i = 0; i < repeats; ++i) {
+      connect(*device, serial, &nanos, &calls);
+    }
+
+    char name[48];
+    snprintf(name, sizeof(name), "%u modes", numModes);
+    printf("%-44s %12.1f %12llu\n", name, nanos / repeats / 1000, static_cast<unsigned long long>(calls / repeats));
+  }
+}
+
+int main() {
+  benchHelpers();
+  benchFrames(false);
+  benchFrames(true);
+  benchHandshake();
+  return 0;
+}
@@ -0,0 +1,141 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * Multi-port hub
+ *
+ * A `LumpHub` runs N simulated ports from one loop with a 50 us period. Every host streams DATA frames back to back
+ * at 115200 baud, and every device streams a scheduled mode at 1 kHz. For each N, reports the time until all ports
+ * are connected, the aggregate throughput over one second of virtual time, the worst-case gap between two runs of the
+ * same port (`maxServiceGap()`) and the host time per `LumpHub::run()`.
+ *
+ * The virtual clock only moves between loop iterations, so the MCU time spent in `run()` is modeled: each received
+ * byte costs `byteCostMicros`. This makes the gaps depend on the work done by the other ports.
+ */
+
+#include "host/LumpHost.h"
+
+#include "LumpBench.h"
+#include <memory>
+
+using namespace LumpBench;
+using LumpHost::HostEmulator;
+using LumpHost::MockSerial;
+
+static const uint32_t loopMicros     = 50;
+static const uint32_t byteCostMicros = 1; // MCU time to read and parse one byte.
+static const uint8_t maxPorts        = 6;
+
+/* Mock UART that advances the virtual clock by the modeled parse cost of each byte. */
+class CostSerial : public MockSerial {
+  public:
+    int read() {
+      int c = MockSerial::read();
+      if (c >= 0) {
+        LumpHost::advance(byteCostMicros);
+      }
+      return c;
+    }
+};
+
+static const LumpMode modes[]{
+    {"Echo", DATA8, 8, 4, 0, "", false, false, false, LUMP_INFO_MAPPING_NONE, LUMP_INFO_MAPPING_ABS},
+};
+
+static bool sample(uint8_t mode, void *data) { return true; }
+
+static const LumpModeSchedule schedules[]{
+    {sample, 1000},
+};
+
+struct Port {
+    CostSerial serial;
+    HostEmulator host{serial};
+    LumpDevice<CostSerial> device{&serial, 1, 2, 68, LUMP_UART_SPEED_LPF2, modes, 1};
+};
+
+static void simulate(uint8_t numPorts) {
+  LumpHost::resetClock();
+  std::vector<std::unique_ptr<Port>> ports;
+  LumpHub<maxPorts> hub;
+  for (uint8_t i = 0; i < numPorts; ++i) {
+    ports.emplace_back(new Port);
+    ports.back()->device.setSchedules(schedules, 1);
+    hub.add(ports.back()->device);
+  }
+  hub.begin();
+  hub.setRxBudget(64);
+
+  auto step = [&] {
+    for (auto &p : ports) {
+      p->host.step();
+    }
+    hub.run();
+    LumpHost::advance(loopMicros);
+  };
+
+  auto connected = [&] {
+    for (auto &p : ports) {
+      if (p->device.state() != LumpDeviceState::Communicating) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  while (!connected() && LumpHost::clock().load() < 10000000) {
+    step();
+  }
+  double handshakeMillis = LumpHost::clock().load() / 1000.0;
+
+  /* Streams one second of back-to-back DATA frames to every port. */
+  std::vector<uint8_t> frame = hostMsg(LUMP_MSG_TYPE_DATA, 0, {1, 2, 3, 4, 5, 6, 7, 8});
+  std::vector<uint8_t> stream;
+  while (stream.size() * ports[0]->serial.byteMicros() < 1000000) {
+    stream.insert(stream.end(), frame.begin(), frame.end());
+  }
+
+  uint64_t rxMsgs = 0;
+  uint64_t txMsgs = 0;
+  for (auto &p : ports) {
+    p->host.keepAlive = false;
+    p->serial.hostWrite(stream.data(), stream.size());
+    rxMsgs -= p->device.linkStats().rxMsgs;
+    txMsgs -= p->device.linkStats().txDataMsgs;
+  }
+  hub.resetStats();
+
+  uint64_t runs      = 0;
+  double hostSeconds = 0;
+  uint64_t end       = LumpHost::clock().load() + 1000000;
+  while (LumpHost::clock().load() < end) {
+    for (auto &p : ports) {
+      p->host.step();
+    }
+    double start = nowSeconds();
+    hub.run();
+    hostSeconds += nowSeconds() - start;
+    ++runs;
+    LumpHost::advance(loopMicros);
+  }
+
+  for (auto &p : ports) {
+    rxMsgs += p->device.linkStats().rxMsgs;
+    txMsgs += p->device.linkStats().txDataMsgs;
+  }
+
+  printf("%5u %14.1f %12llu %12llu %14u %14.1f\n", numPorts, handshakeMillis, static_cast<unsigned long long>(rxMsgs),
+         static_cast<unsigned long long>(txMsgs), hub.maxServiceGap(), hostSeconds * 1e9 / runs);
+}
+
+int main() {
+  header("LumpHub, 115200 baud per port, 1 s of back-to-back 10-byte DATA frames in, 1 kHz DATA frames out");
+  printf("%5s %14s %12s %12s %14s %14s\n", "ports", "handshake ms", "RX msgs/s", "TX msgs/s", "max gap us",
+         "ns/run()");
+
+  for (uint8_t numPorts : {1, 2, 4, 6}) {
+    simulate(numPorts);
+  }
+  return 0;
+}
@@ -0,0 +1,78 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * RX burst size
+ *
+ * The host streams DATA frames at 460800 baud for one second of virtual time while the sketch calls `run()` once per
+ * loop period. For each burst size and loop period, reports the bytes parsed per `run()`, the peak backlog in the
+ * core's RX buffer and the highest speed the parser sustains at that period.
+ */
+
+#include "host/LumpHost.h"
+
+#include "LumpBench.h"
+
+using namespace LumpBench;
+using LumpHost::HostEmulator;
+using LumpHost::MockSerial;
+
+static const LumpMode modes[]{
+    {"Echo", DATA8, 8, 4, 0, "", false, false, false, LUMP_INFO_MAPPING_NONE, LUMP_INFO_MAPPING_ABS},
+};
+
+static const uint32_t speed         = LUMP_UART_SPEED_MAX;
+static const uint32_t coreRxBufSize = 256; // Default RX buffer of the ESP32 core.
+
+static void simulate(uint8_t burst, uint32_t loopMicros) {
+  LumpHost::resetClock();
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, speed, modes, 1);
+  device.begin();
+  device.setRxBurstSize(burst);
+
+  while (device.state() != LumpDeviceState::Communicating) {
+    host.step();
+    device.run();
+    LumpHost::advance(100);
+  }
+
+  /* Streams one second of back-to-back DATA frames. */
+  host.keepAlive = false;
+  std::vector<uint8_t> frame = hostMsg(LUMP_MSG_TYPE_DATA, 0, {1, 2, 3, 4, 5, 6, 7, 8});
+  std::vector<uint8_t> stream;
+  while (stream.size() * serial.byteMicros() < 1000000) {
+    stream.insert(stream.end(), frame.begin(), frame.end());
+  }
+  serial.hostWrite(stream.data(), stream.size());
+
+  uint64_t startBytes = device.linkStats().rxBytes;
+  uint64_t runs       = 0;
+  int peakBacklog     = 0;
+  uint64_t end        = LumpHost::clock().load() + 1000000;
+  while (LumpHost::clock().load() < end) {
+    peakBacklog = max(peakBacklog, serial.available());
+    device.run();
+    ++runs;
+    LumpHost::advance(loopMicros);
+  }
+
+  double bytesPerRun = static_cast<double>(device.linkStats().rxBytes - startBytes) / runs;
+  double maxBaud     = burst * 10.0 * 1e6 / loopMicros;
+  printf("%5u %8u %14.1f %14d %10s %14.0f\n", burst, loopMicros, bytesPerRun, peakBacklog,
+         peakBacklog > static_cast<int>(coreRxBufSize) ? "yes" : "no", maxBaud);
+}
+
+int main() {
+  header("RX burst at 460800 baud, 1 s of back-to-back 10-byte DATA frames");
+  printf("%5s %8s %14s %14s %10s %14s\n", "burst", "loop us", "bytes/run()", "peak backlog", "overrun", "max baud");
+
+  for (uint32_t loopMicros : {50, 200, 1000, 5000}) {
+    for (uint8_t burst : {1, 16, 64}) {
+      simulate(burst, loopMicros);
+    }
+  }
+  return 0;
+}
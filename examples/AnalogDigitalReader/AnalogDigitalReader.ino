@@ -21,7 +21,7 @@
 #include <LumpDeviceBuilder.h>
 
 // Define the supported modes for the device.
-LumpMode modes[]{
+const LumpMode modes[]{
     {"Analog", DATA16, 1, 4, 0, "raw", {0, 4095}, {0, 100}, {0, 4095}},
     {"Digital", DATA8, 1, 1, 0, "raw", {0, 1}, {0, 100}, {0, 1}}
 };
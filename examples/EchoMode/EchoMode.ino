@@ -19,10 +19,13 @@
 #include <LumpDeviceBuilder.h>
 
 // Define the supported modes for the device.
-LumpMode modes[]{
+constexpr LumpMode modes[]{
     {"Echo", DATA16, NUM_DATA, 4, 0, "", {-1023, 1023}, {0, 100}, {-1023, 1023}, LUMP_INFO_MAPPING_NONE, LUMP_INFO_MAPPING_ABS}
 };
 
+// Modes with an output mapping need a buffer in the data message arena.
+static_assert(lumpDataMsgFootprint(modes) <= LUMP_DATA_MSG_ARENA_SIZE, "Increase LUMP_DATA_MSG_ARENA_SIZE");
+
 uint8_t numModes = sizeof(modes) / sizeof(LumpMode);
 
 // Instantiate the device.
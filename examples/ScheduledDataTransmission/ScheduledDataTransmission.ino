@@ -0,0 +1,67 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * Scheduled Data Transmission Example
+ *
+ * Same device as the "Event-Driven Data Transmission" example, but the library samples the modes and sends the data
+ * messages on schedule. The sketch only provides a sampler and an init hook for each mode.
+ */
+
+// Select a serial interface for device communication.
+#define DEVICE_SERIAL Serial0
+#define RX_PIN        20
+#define TX_PIN        21
+
+// Pin definitions.
+#define ANALOG_PIN  3
+#define DIGITAL_PIN 4
+
+#include <LumpDeviceBuilder.h>
+
+// Define the supported modes for the device.
+const LumpMode modes[]{
+    {"Analog", DATA16, 1, 4, 0, "raw", {0, 4095}, {0, 100}, {0, 4095}},
+    {"Digital", DATA8, 1, 1, 0, "raw", {0, 1}, {0, 100}, {0, 1}}
+};
+
+uint8_t numModes = sizeof(modes) / sizeof(LumpMode);
+
+// Define the samplers and init hooks for each mode.
+bool sampleAnalog(uint8_t mode, void *data) {
+  *static_cast<int16_t *>(data) = analogRead(ANALOG_PIN);
+  return true;
+}
+
+bool sampleDigital(uint8_t mode, void *data) {
+  *static_cast<int8_t *>(data) = digitalRead(DIGITAL_PIN);
+  return true;
+}
+
+void initAnalog(uint8_t mode) {
+  pinMode(ANALOG_PIN, INPUT);
+}
+
+void initDigital(uint8_t mode) {
+  pinMode(DIGITAL_PIN, INPUT);
+}
+
+// Define the schedule for each mode.
+const LumpModeSchedule schedules[]{
+    {sampleAnalog, 1000, LumpSendPolicy::OnChange, 8, initAnalog},  // 1000Hz, sends when the value changes by 8 or more.
+    {sampleDigital, 1000, LumpSendPolicy::OnChange, 0, initDigital} // 1000Hz, sends when the value changes.
+};
+
+// Instantiate the device.
+LumpDevice<HardwareSerial> device(&DEVICE_SERIAL, RX_PIN, TX_PIN, 68, 115200, modes, numModes);
+
+// Initialize the device and run it.
+void setup() {
+  device.setSchedules(schedules, numModes);
+  device.begin();
+}
+
+void loop() {
+  device.run();
+}
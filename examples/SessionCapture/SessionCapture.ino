@@ -0,0 +1,51 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * Session Capture Example
+ *
+ * Records the traffic between the device and the host, from AutoID through the handshake to communication, and
+ * streams the capture to the USB serial port. Save the output to a file and feed it to `LumpReplaySerial` on a host
+ * to reproduce the session.
+ */
+
+// Select a serial interface for device communication.
+#define DEVICE_SERIAL Serial0
+#define RX_PIN        20
+#define TX_PIN        21
+
+// Select a serial interface for the capture. It must be fast enough not to disturb the protocol timing.
+#define CAPTURE_SERIAL Serial
+#define CAPTURE_SPEED  2000000
+
+#include <LumpDeviceBuilderCapture.h>
+
+// Define the supported modes for the device.
+const LumpMode modes[]{
+    {"Counter", DATA16, 1, 4, 0},
+};
+
+uint8_t numModes = sizeof(modes) / sizeof(LumpMode);
+
+// Wrap the serial interface to capture the session.
+typedef LumpCaptureSerial<HardwareSerial, decltype(CAPTURE_SERIAL)> CaptureSerial;
+CaptureSerial captureSerial(&DEVICE_SERIAL, &CAPTURE_SERIAL);
+
+// Instantiate the device.
+LumpDevice<CaptureSerial> device(&captureSerial, RX_PIN, TX_PIN, 68, 115200, modes, numModes);
+
+int16_t counter = 0;
+
+void setup() {
+  CAPTURE_SERIAL.begin(CAPTURE_SPEED);
+  device.begin();
+}
+
+void loop() {
+  device.run();
+
+  if (device.state() == LumpDeviceState::Communicating && device.hasNack()) {
+    device.send(counter++);
+  }
+}
@@ -0,0 +1,57 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * Threaded Runner Example (ESP32)
+ *
+ * The LUMP protocol runs in its own FreeRTOS task on core 0, so sensor processing in `loop()` cannot delay
+ * NACK handling. `loop()` publishes samples without waiting for the protocol task.
+ *
+ * On RP2040 (arduino-pico), call `device.runProtocol()` from `loop1()` instead of creating a task.
+ */
+
+// Select a serial interface for device communication.
+#define DEVICE_SERIAL Serial0
+#define RX_PIN        20
+#define TX_PIN        21
+
+// Pin definitions.
+#define ANALOG_PIN 3
+
+// Enable the threaded runner before including the library.
+#define LUMP_THREADED_RUNNER 1
+#include <LumpDeviceBuilder.h>
+
+// Define the supported modes for the device.
+const LumpMode modes[]{
+    {"Analog", DATA16, 1, 4, 0, "raw", {0, 4095}, {0, 100}, {0, 4095}},
+};
+
+uint8_t numModes = sizeof(modes) / sizeof(LumpMode);
+
+// Instantiate the device.
+LumpDevice<HardwareSerial> device(&DEVICE_SERIAL, RX_PIN, TX_PIN, 68, 115200, modes, numModes);
+
+// Initialize the device and start the protocol task.
+void setup() {
+  pinMode(ANALOG_PIN, INPUT);
+  device.begin();
+  xTaskCreatePinnedToCore(LumpDevice<HardwareSerial>::protocolTask, "lump", 4096, &device, 5, nullptr, 0);
+}
+
+// Process and publish the samples.
+void loop() {
+  // state() and mode() are published atomically by the protocol task, so they may be read here.
+  if (device.state() == LumpDeviceState::Communicating && device.mode() == 0) {
+    int16_t value = analogRead(ANALOG_PIN);
+    device.publish(value, 0);
+  }
+
+  LumpSample msg;
+  if (device.takeCmdWrite(msg)) {
+    // Handle the LUMP_CMD_WRITE payload in msg.payload (msg.size bytes).
+  }
+
+  delay(1);
+}
@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+# SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+# SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+# SPDX-License-Identifier: MIT
+
+"""
+Decoder for the traces dumped by `LumpDevice::dumpTrace()`.
+
+Usage:
+    python3 lump_trace.py capture.bin
+
+The input may contain other output (e.g., debug text); every dump found in it is decoded.
+"""
+
+import struct
+import sys
+
+MAGIC = b"LTRC"
+HEADER = struct.Struct("<4sBBHI")
+RECORD = struct.Struct("<IBB6s")
+
+# Must match `LumpDeviceState` and `LumpTraceEvent` in `LumpDeviceBuilder.h`.
+STATES = [
+    "InitWdt", "Reset",
+    "InitAutoId", "WaitingAutoId", "InitUart", "WaitingUartInit", "SendingType", "SendingModes", "SendingSpeed",
+    "SendingVersion", "SendingName", "SendingValueSpans", "SendingSymbol", "SendingMapping", "SendingModeCombos",
+    "SendingFormat", "InterModePause", "WaitingTxDrain", "SendingAck", "WaitingAckReply", "SwitchingUartSpeed",
+    "InitMode", "Communicating", "SendingNack",
+]
+EVENTS = ["State", "RX", "TX", "ChecksumError", "InvalidSize", "AckTimeout", "NackTimeout", "TxDrop"]
+
+
+def describe(event, arg, data):
+    name = EVENTS[event] if event < len(EVENTS) else f"Event{event}"
+    if name == "State":
+        return f"{name:<13} {STATES[arg] if arg < len(STATES) else arg}"
+    if name in ("RX", "TX"):
+        shown = data[: min(arg, len(data))]
+        more = " ..." if arg > len(data) else ""
+        return f"{name:<13} [{arg:3}] {shown.hex(' ')}{more}"
+    if name == "ChecksumError":
+        return f"{name:<13} expected 0x{arg:02x} got 0x{data[0]:02x}"
+    if name == "InvalidSize":
+        return f"{name:<13} size {arg}, header {data[0]:02x}"
+    if name == "TxDrop":
+        return f"{name:<13} mode {arg}"
+    return name
+
+
+def decode(blob):
+    pos = blob.find(MAGIC)
+    while pos >= 0:
+        magic, version, size, num, lost = HEADER.unpack_from(blob, pos)
+        if version != 1 or size != RECORD.size:
+            raise ValueError(f"unsupported trace format (version {version}, record size {size})")
+        pos += HEADER.size
+
+        print(f"--- {num} records, {lost} lost ---")
+        start = None
+        for _ in range(num):
+            micros, event, arg, data = RECORD.unpack_from(blob, pos)
+            pos += RECORD.size
+            start = micros if start is None else start
+            elapsed = (micros - start) & 0xFFFFFFFF
+            print(f"{elapsed / 1000:12.3f} ms  {describe(event, arg, data)}")
+
+        pos = blob.find(MAGIC, pos)
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    with open(sys.argv[1], "rb") as f:
+        decode(f.read())
@@ -4,197 +4,8 @@
 
 #include "LumpDeviceBuilder.h"
 
-namespace LumpDeviceBuilder {
-
-  LumpValueSpan::LumpValueSpan(float min, float max) : min{min}, max{max} {
-    isValid = min <= max;
-  }
-
-  LumpValueSpan::LumpValueSpan(bool isExist) : isExist{isExist} {}
-
-  LumpMode::LumpMode(
-      const char *name,
-      uint8_t dataType,
-      uint8_t numData,
-      uint8_t figures,
-      uint8_t decimals,
-      const char *symbol,
-      LumpValueSpan raw,
-      LumpValueSpan pct,
-      LumpValueSpan si,
-      uint8_t mapIn,
-      uint8_t mapOut,
-      bool power,
-      bool flagsInName
-  )
-      : dataType{dataType},
-        numData{numData},
-        figures{figures},
-        decimals{decimals},
-        raw{raw},
-        pct{pct},
-        si{si},
-        mapIn{mapIn},
-        mapOut{mapOut},
-        power{power},
-        flagsInName{flagsInName} {
-    using namespace LumpDeviceBuilder::Internal;
-
-    if (name && flagsInName) {
-      memcpy(this->name, name, LUMP_MAX_SHORT_NAME_SIZE + 7);
-    } else if (name && strlen(name) > 0 && isalpha(name[0])) {
-      size_t nameLen = min(strlen(name), static_cast<size_t>(LUMP_MAX_NAME_SIZE));
-      strncpy(this->name, name, nameLen);
-    }
-
-    if (symbol && strlen(symbol) > 0) {
-      size_t symbolLen = min(strlen(symbol), static_cast<size_t>(LUMP_MAX_UOM_SIZE));
-      strncpy(this->symbol, symbol, symbolLen);
-    }
-
-    dataTypeSize = sizeOfLumpDataType(dataType);
-    dataMsgSize  = numData * dataTypeSize;
-
-    if (mapOut != LUMP_INFO_MAPPING_NONE) {
-      dataMsg = calloc(numData, dataTypeSize);
-    }
-  }
-
-  LumpMode::~LumpMode() {
-    if (dataMsg) {
-      free(dataMsg);
-      dataMsg = nullptr;
-    }
-  }
-
-  LumpMode::LumpMode(const LumpMode &other)
-      : dataType{other.dataType},
-        numData{other.numData},
-        figures{other.figures},
-        decimals{other.decimals},
-        raw{other.raw},
-        pct{other.pct},
-        si{other.si},
-        mapIn{other.mapIn},
-        mapOut{other.mapOut},
-        power{other.power},
-        flagsInName{other.flagsInName},
-        dataTypeSize{other.dataTypeSize},
-        dataMsgSize{other.dataMsgSize},
-        hasDataMsg{other.hasDataMsg} {
-    memcpy(name, other.name, sizeof(name));
-    memcpy(symbol, other.symbol, sizeof(symbol));
-
-    if (mapOut != LUMP_INFO_MAPPING_NONE) {
-      dataMsg = malloc(dataMsgSize);
-      memcpy(dataMsg, other.dataMsg, dataMsgSize);
-    }
-  }
-
-  LumpMode &LumpMode::operator=(const LumpMode &other) {
-    if (this != &other) {
-      if (dataMsg) {
-        free(dataMsg);
-        dataMsg = nullptr;
-      }
-
-      dataType     = other.dataType;
-      numData      = other.numData;
-      figures      = other.figures;
-      decimals     = other.decimals;
-      raw          = other.raw;
-      pct          = other.pct;
-      si           = other.si;
-      mapIn        = other.mapIn;
-      mapOut       = other.mapOut;
-      power        = other.power;
-      flagsInName  = other.flagsInName;
-      dataTypeSize = other.dataTypeSize;
-      dataMsgSize  = other.dataMsgSize;
-      hasDataMsg   = other.hasDataMsg;
-
-      memcpy(name, other.name, sizeof(name));
-      memcpy(symbol, other.symbol, sizeof(symbol));
-
-      if (mapOut != LUMP_INFO_MAPPING_NONE) {
-        dataMsg = malloc(dataMsgSize);
-        memcpy(dataMsg, other.dataMsg, dataMsgSize);
-      }
-    }
-    return *this;
-  }
-
-  LumpMode::LumpMode(LumpMode &&other) noexcept
-      : dataType{other.dataType},
-        numData{other.numData},
-        figures{other.figures},
-        decimals{other.decimals},
-        raw{other.raw},
-        pct{other.pct},
-        si{other.si},
-        mapIn{other.mapIn},
-        mapOut{other.mapOut},
-        power{other.power},
-        flagsInName{other.flagsInName},
-        dataTypeSize{other.dataTypeSize},
-        dataMsgSize{other.dataMsgSize},
-        hasDataMsg{other.hasDataMsg} {
-    memcpy(name, other.name, sizeof(name));
-    memcpy(symbol, other.symbol, sizeof(symbol));
-
-    dataMsg       = other.dataMsg;
-    other.dataMsg = nullptr;
-  }
-
-  LumpMode &LumpMode::operator=(LumpMode &&other) noexcept {
-    if (this != &other) {
-      if (dataMsg) {
-        free(dataMsg);
-        dataMsg = nullptr;
-      }
-
-      dataType     = other.dataType;
-      numData      = other.numData;
-      figures      = other.figures;
-      decimals     = other.decimals;
-      raw          = other.raw;
-      pct          = other.pct;
-      si           = other.si;
-      mapIn        = other.mapIn;
-      mapOut       = other.mapOut;
-      power        = other.power;
-      flagsInName  = other.flagsInName;
-      dataTypeSize = other.dataTypeSize;
-      dataMsgSize  = other.dataMsgSize;
-      hasDataMsg   = other.hasDataMsg;
-
-      memcpy(name, other.name, sizeof(name));
-      memcpy(symbol, other.symbol, sizeof(symbol));
-
-      dataMsg       = other.dataMsg;
-      other.dataMsg = nullptr;
-    }
-    return *this;
-  }
-
-} // namespace LumpDeviceBuilder
-
 namespace LumpDeviceBuilder::Internal {
 
-  uint8_t sizeOfLumpDataType(uint8_t dataType) {
-    switch (dataType) {
-      case LUMP_DATA_TYPE_DATA8:
-        return 1;
-      case LUMP_DATA_TYPE_DATA16:
-        return 2;
-      case LUMP_DATA_TYPE_DATA32:
-      case LUMP_DATA_TYPE_DATAF:
-        return 4;
-      default:
-        return 0;
-    }
-  }
-
   uint32_t versionToBcd(uint32_t version) {
     uint32_t bcd  = 0;
     uint8_t shift = 0;
@@ -206,46 +17,44 @@ namespace LumpDeviceBuilder::Internal {
     return bcd;
   }
 
-  uint8_t calcChecksum(uint8_t *msg, uint8_t size) {
-    uint8_t checksum{0xff};
-    while (size--) {
-      checksum ^= *msg++;
+  uint8_t sizeOfMsg(uint8_t header) {
+    switch (header & LUMP_MSG_TYPE_MASK) {
+      case LUMP_MSG_TYPE_SYS:
+        return 1;
+      case LUMP_MSG_TYPE_INFO:
+        return LUMP_MSG_SIZE(header) + 3; // +3 for header, INFO type and checksum.
+      default:
+        return LUMP_MSG_SIZE(header) + 2; // +2 for header and checksum.
     }
-    return checksum;
   }
 
-  uint8_t queryLog2(uint8_t x) {
-    switch (x) {
-      case 1:
-        return 0;
-      case 2:
-        return 1;
-      case 4:
-        return 2;
-      case 8:
-        return 3;
-      case 16:
-        return 4;
-      case 32:
-        return 5;
-      default:
-        return 255; // error
+  template <typename U>
+  static bool exceedsDeadband(const uint8_t *payload, const uint8_t *ref, uint8_t numData, float deadband) {
+    for (uint8_t i = 0; i < numData; ++i) {
+      U value, refValue;
+      memcpy(&value, &payload[i * sizeof(U)], sizeof(U));
+      memcpy(&refValue, &ref[i * sizeof(U)], sizeof(U));
+
+      if (value != refValue && fabs(static_cast<float>(value) - static_cast<float>(refValue)) >= deadband) {
+        return true;
+      }
     }
+    return false;
   }
 
-  uint8_t queryNextPow2(uint8_t x) {
-    if (x == 0 || x == 1 || x == 2)
-      return x;
-    else if (x <= 4)
-      return 4;
-    else if (x <= 8)
-      return 8;
-    else if (x <= 16)
-      return 16;
-    else if (x <= 32)
-      return 32;
-    else
-      return 255; // error
+  bool exceedsDeadband(const uint8_t *payload, const uint8_t *ref, uint8_t dataType, uint8_t numData, float deadband) {
+    switch (dataType) {
+      case LUMP_DATA_TYPE_DATA8:
+        return exceedsDeadband<int8_t>(payload, ref, numData, deadband);
+      case LUMP_DATA_TYPE_DATA16:
+        return exceedsDeadband<int16_t>(payload, ref, numData, deadband);
+      case LUMP_DATA_TYPE_DATA32:
+        return exceedsDeadband<int32_t>(payload, ref, numData, deadband);
+      case LUMP_DATA_TYPE_DATAF:
+        return exceedsDeadband<float>(payload, ref, numData, deadband);
+      default:
+        return false;
+    }
   }
 
 } // namespace LumpDeviceBuilder::Internal
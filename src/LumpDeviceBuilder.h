@@ -12,8 +12,331 @@
 #define LUMP_DEVICE_BUILDER_H
 
 #include "LumpDeviceBuilderDebug.h"
+#include "LumpDeviceBuilderPlatform.h"
 #include "lump_ext.h"
-#include <Arduino.h>
+
+/* Link statistics */
+#if LUMP_LINK_STATS
+  #define LUMP_LINK_STATS_ADD(counter, n) (linkStatsData.counter += (n))
+#else
+  #define LUMP_LINK_STATS_ADD(counter, n)
+#endif
+#define LUMP_LINK_STATS_INC(counter) LUMP_LINK_STATS_ADD(counter, 1)
+
+/* Internal namespace for the LUMP Device Builder Library. */
+namespace LumpDeviceBuilder::Internal {
+
+  /**
+   * Converts a decimal version number to BCD format.
+   *
+   * @param version Version number.
+   * @return Version number in BCD format.
+   */
+  uint32_t versionToBcd(uint32_t version);
+
+  /**
+   * Calculates the checksum of a message.
+   *
+   * @param msg Pointer to the message.
+   * @param size Size of the message.
+   * @return Checksum of the message.
+   */
+  inline uint8_t calcChecksum(const uint8_t *msg, uint8_t size) {
+    uint8_t checksum{0xff};
+    while (size--) {
+      checksum ^= *msg++;
+    }
+    return checksum;
+  }
+
+  /**
+   * Queries size of the LUMP data type.
+   *
+   * @param dataType LUMP data type.
+   * @return Size of the data type in bytes.
+   */
+  constexpr uint8_t sizeOfLumpDataType(uint8_t dataType) {
+    return (dataType == LUMP_DATA_TYPE_DATA8)                                         ? 1
+           : (dataType == LUMP_DATA_TYPE_DATA16)                                      ? 2
+           : (dataType == LUMP_DATA_TYPE_DATA32 || dataType == LUMP_DATA_TYPE_DATAF) ? 4
+                                                                                      : 0;
+  }
+
+  /**
+   * Queries the size of a message from its header.
+   *
+   * @param header Message header.
+   * @return Size of the message in bytes (including header, INFO type and checksum).
+   */
+  uint8_t sizeOfMsg(uint8_t header);
+
+  /**
+   * Checks if any value of a payload differs from a reference payload by at least a deadband.
+   *
+   * @param payload Payload to check.
+   * @param ref Reference payload.
+   * @param dataType Data type of the values.
+   * @param numData Number of values.
+   * @param deadband Minimum change of a value.
+   * @retval true At least one value changed by `deadband` or more.
+   * @retval false Otherwise.
+   */
+  bool exceedsDeadband(const uint8_t *payload, const uint8_t *ref, uint8_t dataType, uint8_t numData, float deadband);
+
+  /**
+   * Queries log2 (up to 32).
+   *
+   * @param x Value to query.
+   * @return Base-2 logarithm of `x`.
+   */
+  constexpr uint8_t queryLog2(uint8_t x) {
+    return (x == 1)    ? 0
+           : (x == 2)  ? 1
+           : (x == 4)  ? 2
+           : (x == 8)  ? 3
+           : (x == 16) ? 4
+           : (x == 32) ? 5
+                       : 255; // error
+  }
+
+  /**
+   * Queries the next power of 2 (up to 32).
+   *
+   * @param x Value to query.
+   * @return Smallest power of 2 greater than or equal to `x`.
+   */
+  constexpr uint8_t queryNextPow2(uint8_t x) {
+    return (x <= 2)    ? x
+           : (x <= 4)  ? 4
+           : (x <= 8)  ? 8
+           : (x <= 16) ? 16
+           : (x <= 32) ? 32
+                       : 255; // error
+  }
+
+  /**
+   * Queries the free space of the UART TX buffer.
+   *
+   * @tparam T Type of the serial interface.
+   * @param uart Serial interface.
+   * @return Number of bytes that can be written without blocking.
+   */
+  template <typename T>
+  inline auto availableForWrite(T *uart, int) -> decltype(uart->availableForWrite()) {
+    return uart->availableForWrite();
+  }
+
+  /**
+   * Fallback for serial interfaces without `availableForWrite()`.
+   *
+   * @return Always `0`, which means the free space is unknown.
+   */
+  template <typename T>
+  inline int availableForWrite(T *, long) {
+    return 0;
+  }
+
+#ifdef __AVR__
+  typedef uint8_t RingIndex; // Single-byte loads and stores are atomic on 8-bit MCUs.
+#else
+  typedef uint32_t RingIndex;
+#endif
+
+  /**
+   * Lock-free triple buffer for passing the latest value from one thread to another.
+   *
+   * The producer and the consumer each own a slot. The third slot is exchanged atomically, so both sides are
+   * wait-free and the consumer always gets the most recent complete value.
+   *
+   * @tparam U Type of the value.
+   */
+  template <typename U>
+  class TripleBuffer {
+    public:
+      /**
+       * Gets the slot to write the next value into (producer side).
+       */
+      inline U &back() { return slots[backIdx]; }
+
+      /**
+       * Publishes the value written into `back()` (producer side).
+       */
+      inline void publish() {
+        backIdx = __atomic_exchange_n(&middle, static_cast<uint8_t>(backIdx | dirty), __ATOMIC_ACQ_REL) & index;
+      }
+
+      /**
+       * Takes the latest published value into `front()` (consumer side).
+       *
+       * @retval true A new value is available in `front()`.
+       * @retval false No value has been published since the last call.
+       */
+      inline bool update() {
+        if (!(__atomic_load_n(&middle, __ATOMIC_ACQUIRE) & dirty)) {
+          return false;
+        }
+        frontIdx = __atomic_exchange_n(&middle, frontIdx, __ATOMIC_ACQ_REL) & index;
+        return true;
+      }
+
+      /**
+       * Gets the latest value taken by `update()` (consumer side).
+       */
+      inline const U &front() const { return slots[frontIdx]; }
+
+    private:
+      static constexpr uint8_t index = 0x03;
+      static constexpr uint8_t dirty = 0x04;
+
+      U slots[3]{};
+      uint8_t backIdx{0};
+      uint8_t middle{1};
+      uint8_t frontIdx{2};
+  };
+
+  /**
+   * Lock-free single-producer/single-consumer byte ring.
+   *
+   * The producer (e.g., a UART RX interrupt) only writes `head`, the consumer (`run()`) only writes `tail`.
+   * Indices run freely and are masked on access.
+   *
+   * @tparam Size Capacity in bytes, must be a power of two.
+   */
+  template <uint32_t Size>
+  class SpscRing {
+      static_assert(Size && !(Size & (Size - 1)), "Size must be a power of two");
+      static_assert(Size <= static_cast<RingIndex>(~static_cast<RingIndex>(0)) / 2 + 1, "Size is too large");
+
+    public:
+      /**
+       * Pushes a byte (producer side).
+       *
+       * @param c Byte to push.
+       * @retval true The byte has been pushed.
+       * @retval false The ring is full, the byte is dropped.
+       */
+      inline bool push(uint8_t c) {
+        RingIndex used = head - __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+        if (used >= Size) {
+          ++overflows;
+          return false;
+        }
+
+        buffer[head & (Size - 1)] = c;
+        __atomic_store_n(&head, static_cast<RingIndex>(head + 1), __ATOMIC_RELEASE);
+
+        if (used >= highWater) {
+          highWater = used + 1;
+        }
+        return true;
+      }
+
+      /**
+       * Gets the number of bytes in the ring (consumer side).
+       */
+      inline RingIndex available() const { return __atomic_load_n(&head, __ATOMIC_ACQUIRE) - tail; }
+
+      /**
+       * Pops a byte (consumer side). The ring must not be empty.
+       */
+      inline uint8_t pop() {
+        uint8_t c = buffer[tail & (Size - 1)];
+        __atomic_store_n(&tail, static_cast<RingIndex>(tail + 1), __ATOMIC_RELEASE);
+        return c;
+      }
+
+      /**
+       * Discards all bytes in the ring (consumer side).
+       */
+      inline void clear() { __atomic_store_n(&tail, __atomic_load_n(&head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE); }
+
+      /* Statistics (written by the producer) */
+      uint32_t overflows{0};
+      RingIndex highWater{0};
+
+    private:
+      uint8_t buffer[Size]{};
+      RingIndex head{0};
+      RingIndex tail{0};
+  };
+
+  /**
+   * Encodes a message header.
+   *
+   * @param msgType Message type (`lump_msg_type_t`).
+   * @param size Size of the payload.
+   * @param cmd Command or mode number (`lump_cmd_t`).
+   * @return Encoded message header.
+   */
+  constexpr uint8_t encMsgHeader(uint8_t msgType, uint8_t size, uint8_t cmd) {
+    return msgType | (queryLog2(size) << LUMP_MSG_SIZE_SHIFT) | cmd;
+  }
+
+  /**
+   * Queries the next lower speed of the adaptive speed ladder.
+   *
+   * Ladder: `LUMP_UART_SPEED_MAX`, `LUMP_UART_SPEED_HIGH`, `LUMP_UART_SPEED_LPF2`, `LUMP_UART_SPEED_MID`.
+   *
+   * @param speed Current speed.
+   * @return Next lower speed, or `speed` if it is already at the bottom of the ladder.
+   */
+  constexpr uint32_t lowerUartSpeed(uint32_t speed) {
+    return (speed > LUMP_UART_SPEED_MAX)    ? LUMP_UART_SPEED_MAX
+           : (speed > LUMP_UART_SPEED_HIGH) ? LUMP_UART_SPEED_HIGH
+           : (speed > LUMP_UART_SPEED_LPF2) ? LUMP_UART_SPEED_LPF2
+           : (speed > LUMP_UART_SPEED_MID)  ? LUMP_UART_SPEED_MID
+                                            : speed;
+  }
+
+  /**
+   * Checks if a character is a letter (`A–Z`, `a–z`).
+   *
+   * @param c Character to check.
+   * @retval true The character is a letter.
+   * @retval false Otherwise.
+   */
+  constexpr bool isLetter(char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+  }
+
+  /**
+   * Queries the length of a string, up to a limit.
+   *
+   * @param str String to query (may be `nullptr`).
+   * @param limit Maximum length.
+   * @return Length of the string, excluding the null terminator.
+   */
+  constexpr uint8_t strLen(const char *str, uint8_t limit) {
+    return (!str || !limit || !*str) ? 0 : 1 + strLen(str + 1, limit - 1);
+  }
+
+  /**
+   * Gets a character of a mode name, following the naming rules of `LumpMode`.
+   *
+   * @param name Mode name.
+   * @param flagsInName Whether the name contains flags.
+   * @param i Character index.
+   * @return Character at `i`.
+   */
+  constexpr char modeNameAt(const char *name, bool flagsInName, uint8_t i) {
+    return (name && flagsInName) ? ((i < LUMP_MAX_SHORT_NAME_SIZE + 7) ? name[i] : '\0')
+           : (name && isLetter(name[0])) ? ((i < strLen(name, LUMP_MAX_NAME_SIZE)) ? name[i] : '\0')
+           : (i < 4)                     ? "null"[i]
+                                         : '\0';
+  }
+
+  /**
+   * Gets a character of a symbol, following the length limit of `LumpMode`.
+   *
+   * @param symbol Symbol.
+   * @param i Character index.
+   * @return Character at `i`.
+   */
+  constexpr char symbolAt(const char *symbol, uint8_t i) {
+    return (i < strLen(symbol, LUMP_MAX_UOM_SIZE)) ? symbol[i] : '\0';
+  }
+
+} // namespace LumpDeviceBuilder::Internal
 
 /* Namespace for the LUMP Device Builder Library. */
 namespace LumpDeviceBuilder {
@@ -36,8 +359,10 @@ namespace LumpDeviceBuilder {
     SendingValueSpans,  // Sending the value spans.
     SendingSymbol,      // Sending the symbol.
     SendingMapping,     // Sending the mode mapping.
+    SendingModeCombos,  // Sending the mode combinations.
     SendingFormat,      // Sending the data format.
     InterModePause,     // Inter-mode pause.
+    WaitingTxDrain,     // Waiting for the TX buffer to drain.
     SendingAck,         // Sending an ACK.
     WaitingAckReply,    // Waiting for the ACK reply.
     SwitchingUartSpeed, // Switching UART to the communication speed.
@@ -47,6 +372,9 @@ namespace LumpDeviceBuilder {
     SendingNack,   // Sending a NACK.
   };
 
+  /* Number of device states. */
+  constexpr uint8_t LUMP_NUM_DEVICE_STATES = static_cast<uint8_t>(LumpDeviceState::SendingNack) + 1;
+
   /* Represents the state of the LUMP receiver. */
   enum class LumpReceiverState : uint8_t {
     ReadByte,       // Reads a byte.
@@ -58,7 +386,7 @@ namespace LumpDeviceBuilder {
   /* Represents a value span of a LUMP device mode. */
   class LumpValueSpan {
     public:
-      virtual ~LumpValueSpan()                        = default;
+      ~LumpValueSpan()                                = default;
       LumpValueSpan(const LumpValueSpan &)            = default;
       LumpValueSpan(LumpValueSpan &&)                 = default;
       LumpValueSpan &operator=(const LumpValueSpan &) = default;
@@ -70,7 +398,7 @@ namespace LumpDeviceBuilder {
        * @param min Minimum value of the span.
        * @param max Maximum value of the span.
        */
-      LumpValueSpan(float min, float max);
+      constexpr LumpValueSpan(float min, float max) : min{min}, max{max}, isValid{min <= max} {}
 
       /**
        * Creates an empty value span.
@@ -78,7 +406,7 @@ namespace LumpDeviceBuilder {
        * @param isExist Whether the value span exists (default: `false`).
        * @note Used to allow the handshake process to skip sending value span information.
        */
-      LumpValueSpan(bool isExist = false);
+      constexpr LumpValueSpan(bool isExist = false) : isExist{isExist} {}
 
       float min{0};
       float max{0};
@@ -86,14 +414,21 @@ namespace LumpDeviceBuilder {
       bool isExist{true};
   };
 
-  /* Represents a mode of a LUMP device. */
+  /**
+   * Represents a mode of a LUMP device.
+   *
+   * Modes are constant and constexpr-constructible, so a mode table declared as `const` can be placed in flash.
+   * On AVR, `const` data is still copied to RAM: the library reads the table directly and has no `PROGMEM` path.
+   * Only the handshake image of `LUMP_HANDSHAKE_IMAGE()` can be placed in flash.
+   * The runtime state of each mode is kept by `LumpDevice`.
+   */
   class LumpMode {
     public:
-      LumpMode(const LumpMode &);
-      LumpMode &operator=(const LumpMode &);
-      LumpMode(LumpMode &&) noexcept;
-      LumpMode &operator=(LumpMode &&) noexcept;
-      virtual ~LumpMode();
+      ~LumpMode()                           = default;
+      LumpMode(const LumpMode &)            = default;
+      LumpMode(LumpMode &&)                 = default;
+      LumpMode &operator=(const LumpMode &) = default;
+      LumpMode &operator=(LumpMode &&)      = default;
 
       /**
        * Creates a mode.
@@ -152,7 +487,7 @@ namespace LumpDeviceBuilder {
        * @warning When the `power` parameter is set to `true` in any mode,
        *          constant power on SPIKE Hub pin 2 is enabled across all modes.
        */
-      LumpMode(
+      constexpr LumpMode(
           const char *name,
           uint8_t dataType,
           uint8_t numData,
@@ -166,15 +501,46 @@ namespace LumpDeviceBuilder {
           uint8_t mapOut     = LUMP_INFO_MAPPING_NONE,
           bool power         = false,
           bool flagsInName   = false
-      );
+      )
+          : name{Internal::modeNameAt(name, flagsInName, 0),
+                 Internal::modeNameAt(name, flagsInName, 1),
+                 Internal::modeNameAt(name, flagsInName, 2),
+                 Internal::modeNameAt(name, flagsInName, 3),
+                 Internal::modeNameAt(name, flagsInName, 4),
+                 Internal::modeNameAt(name, flagsInName, 5),
+                 Internal::modeNameAt(name, flagsInName, 6),
+                 Internal::modeNameAt(name, flagsInName, 7),
+                 Internal::modeNameAt(name, flagsInName, 8),
+                 Internal::modeNameAt(name, flagsInName, 9),
+                 Internal::modeNameAt(name, flagsInName, 10),
+                 Internal::modeNameAt(name, flagsInName, 11),
+                 '\0'},
+            dataType{dataType},
+            numData{numData},
+            figures{figures},
+            decimals{decimals},
+            symbol{Internal::symbolAt(symbol, 0),
+                   Internal::symbolAt(symbol, 1),
+                   Internal::symbolAt(symbol, 2),
+                   Internal::symbolAt(symbol, 3),
+                   '\0'},
+            raw{raw},
+            pct{pct},
+            si{si},
+            mapIn{mapIn},
+            mapOut{mapOut},
+            power{power},
+            flagsInName{flagsInName},
+            dataTypeSize{Internal::sizeOfLumpDataType(dataType)},
+            dataMsgSize{static_cast<uint8_t>(numData * Internal::sizeOfLumpDataType(dataType))} {}
 
       /* Mode info */
-      char name[LUMP_MAX_SHORT_NAME_SIZE + 8]{"null"};
+      char name[LUMP_MAX_SHORT_NAME_SIZE + 8];
       uint8_t dataType;
       uint8_t numData;
       uint8_t figures;
       uint8_t decimals;
-      char symbol[LUMP_MAX_UOM_SIZE + 1]{""};
+      char symbol[LUMP_MAX_UOM_SIZE + 1];
       LumpValueSpan raw;
       LumpValueSpan pct;
       LumpValueSpan si;
@@ -186,338 +552,1917 @@ namespace LumpDeviceBuilder {
       /* Data message (received from the host) */
       uint8_t dataTypeSize;
       uint8_t dataMsgSize;
-      void *dataMsg{nullptr};
-      bool hasDataMsg{false};
   };
 
   /**
-   * LUMP device class.
+   * Gets the number of bytes required by the data message buffers of a mode table.
    *
-   * @tparam T Type of the serial interface (typically `hardwareSerial`).
+   * Modes with an output mapping (`mapOut`) get a 4-byte aligned buffer from the data message arena of the device.
+   * Declare the modes `constexpr` to check the arena size at compile time:
+   * `static_assert(lumpDataMsgFootprint(modes) <= LUMP_DATA_MSG_ARENA_SIZE, "...");`
+   *
+   * @tparam N Number of modes.
+   * @param modes Mode table.
+   * @param first First mode to count (default: `0`).
+   * @return Number of bytes.
    */
-  template <typename T>
-  class LumpDevice {
-    public:
-      virtual ~LumpDevice()                     = default;
-      LumpDevice(const LumpDevice &)            = default;
-      LumpDevice(LumpDevice &&)                 = default;
-      LumpDevice &operator=(const LumpDevice &) = default;
-      LumpDevice &operator=(LumpDevice &&)      = default;
+  template <size_t N>
+  constexpr uint16_t lumpDataMsgFootprint(const LumpMode (&modes)[N], size_t first = 0) {
+    return (first >= N || first > LUMP_MAX_EXT_MODE)
+               ? 0
+               : ((modes[first].mapOut != LUMP_INFO_MAPPING_NONE) ? ((modes[first].dataMsgSize + 3) & ~3) : 0) +
+                     lumpDataMsgFootprint(modes, first + 1);
+  }
 
-      /**
-       * Creates a device.
-       *
-       * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       * @param uart Serial interface used for UART communication (e.g., `Serial0`, `Serial1`).
-       * @param rxPin RX pin number of the serial interface.
-       * @param txPin TX pin number of the serial interface.
-       * @param type Device type.
-       * @param speed Communication speed.
-       * @param modes Device modes (must be an array of `LumpMode`).
-       * @param numModes Number of modes.
-       *   For SPIKE Hub: `[1..16]`
-       *   For EV3: `[1..8]`
-       *   Modes beyond the limit will be ignored.
-       * @param view Number of modes to show in view and data log (default: `LUMP_VIEW_ALL`).
-       *   Valid range: `[1..16]`.
-       *   Set to `LUMP_VIEW_ALL` to show all modes.
-       * @param fwVersion Firmware version (default: `10000000`).
-       *   Valid range: `[10000000..99999999]`.
-       *   The value `10000000` represents v1.0.00.0000.
-       * @param hwVersion Hardware version (default: `10000000`).
-       *   Valid range: `[10000000..99999999]`.
-       *   The value `10000000` represents v1.0.00.0000.
-       */
-      LumpDevice(
-          T *uart,
-          uint8_t rxPin,
-          uint8_t txPin,
-          uint8_t type,
-          uint32_t speed,
-          LumpMode *modes,
-          uint8_t numModes,
-          uint8_t view       = LUMP_VIEW_ALL,
-          uint32_t fwVersion = 10000000,
-          uint32_t hwVersion = 10000000
-      );
+} // namespace LumpDeviceBuilder
 
-      /**
-       * Starts the device.
-       *
-       * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       */
-      void begin();
+namespace LumpDeviceBuilder::Internal {
 
-      /**
-       * Finishes the device.
-       *
-       * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       */
-      void end();
+  /* Describes a device for the compile-time handshake image. See `lumpHandshakeImage()`. */
+  struct HandshakeSpec {
+      uint8_t type;
+      uint32_t speed;
+      uint8_t view;
+      const LumpMode *modes;
+      uint8_t numModes;
+      const uint16_t *combos;
+      uint8_t numCombos;
+  };
 
-      /**
-       * Sets the watchdog timer callback functions.
-       *
-       * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       * @param initWdtCallback Callback function to initialize the watchdog timer.
-       * @param feedWdtCallback Callback function to feed the watchdog timer.
-       * @param deinitWdtCallback Callback function to deinitialize the watchdog timer.
-       */
-      inline void setWdtCallback(void (*initWdtCallback)(), void (*feedWdtCallback)(), void (*deinitWdtCallback)()) {
-        this->initWdtCallback   = initWdtCallback;
-        this->feedWdtCallback   = feedWdtCallback;
-        this->deinitWdtCallback = deinitWdtCallback;
-      }
+  /**
+   * Clamps the number of modes of a mode table, like the `LumpDevice` constructor.
+   *
+   * @param n Number of modes.
+   * @return Number of modes, up to `LUMP_MAX_EXT_MODE + 1`.
+   */
+  constexpr uint8_t hsNumModes(size_t n) {
+    return (n > LUMP_MAX_EXT_MODE) ? LUMP_MAX_EXT_MODE + 1 : n;
+  }
 
-      /**
-       * Runs the device.
-       *
-       * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       */
-      void run();
+  /**
+   * Clamps the number of mode combinations, like `LumpDevice::setModeCombos()`.
+   *
+   * @param n Number of mode combinations.
+   * @return Number of mode combinations, up to `LUMP_MAX_MODE_COMBOS`.
+   */
+  constexpr uint8_t hsNumCombos(size_t n) {
+    return (n > LUMP_MAX_MODE_COMBOS) ? LUMP_MAX_MODE_COMBOS : n;
+  }
 
-      /**
-       * Gets the device state.
-       *
-       * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       * @return Device state.
-       */
-      inline LumpDeviceState state() { return deviceState; }
+  /* Number of messages sent before the mode information (type, modes and speed). */
+  constexpr uint8_t HS_NUM_DEVICE_MSGS = 3;
+
+  /* Message slots of a mode, in the order they are sent. Messages that are not sent are empty. */
+  enum HandshakeSlot : uint8_t {
+    HS_SLOT_NAME,
+    HS_SLOT_RAW,
+    HS_SLOT_PCT,
+    HS_SLOT_SI,
+    HS_SLOT_SYMBOL,
+    HS_SLOT_MODE_COMBOS,
+    HS_SLOT_FORMAT,
+    HS_NUM_MODE_SLOTS
+  };
+
+  /**
+   * Gets the unbiased IEEE 754 exponent of a positive float.
+   *
+   * @param x Value in `(0, 2^128)`.
+   * @return Exponent `e` with `2^e <= x < 2^(e + 1)`, or `0` for subnormals.
+   */
+  constexpr int16_t floatExponent(float x) {
+    return (x >= 2.0f) ? 1 + floatExponent(x / 2.0f) : (x < 1.0f && x >= 1.17549435e-38f) ? floatExponent(x * 2.0f) - 1 : 0;
+  }
+
+  /**
+   * Gets a power of two as a float.
+   *
+   * @param e Exponent.
+   *   Valid range: `[-149..127]`.
+   * @return `2^e`.
+   */
+  constexpr float floatPow2(int16_t e) {
+    return (e > 0) ? 2.0f * floatPow2(e - 1) : (e < 0) ? 0.5f * floatPow2(e + 1) : 1.0f;
+  }
+
+  /**
+   * Gets the IEEE 754 bits of a non-negative float.
+   *
+   * @param x Value.
+   * @return Bits of `x`.
+   */
+  constexpr uint32_t floatMagnitudeBits(float x) {
+    return (x == 0.0f)             ? 0
+           : (x > 3.40282347e38f)  ? 0x7f800000UL                                           // Infinity.
+           : (x < 1.17549435e-38f) ? static_cast<uint32_t>(x * floatPow2(126) * 8388608.0f) // Subnormal.
+                                   : (static_cast<uint32_t>(floatExponent(x) + 127) << 23) |
+                                         static_cast<uint32_t>((x / floatPow2(floatExponent(x)) - 1.0f) * 8388608.0f);
+  }
+
+  /**
+   * Gets the IEEE 754 bits of a float at compile time, as `memcpy()` gives them at run time.
+   *
+   * The sign is taken with `__builtin_copysignf()`, which is a constant expression in GCC and Clang and keeps `-0.0f`.
+   *
+   * @param x Value (not NaN).
+   * @return Bits of `x`.
+   */
+  constexpr uint32_t floatBits(float x) {
+    return (__builtin_copysignf(1.0f, x) < 0.0f) ? 0x80000000UL | floatMagnitudeBits(-x) : floatMagnitudeBits(x);
+  }
+
+  /**
+   * Gets a byte of a little-endian value.
+   *
+   * @param value Value.
+   * @param i Byte index.
+   * @return Byte `i` of `value`.
+   */
+  constexpr uint8_t byteOf(uint32_t value, uint8_t i) {
+    return static_cast<uint8_t>(value >> (8 * i));
+  }
+
+  /**
+   * Gets the number of characters of a mode name sent in the handshake.
+   *
+   * @param mode Mode.
+   * @return Number of characters.
+   */
+  constexpr uint8_t hsNameLen(const LumpMode &mode) {
+    return mode.flagsInName ? LUMP_MAX_SHORT_NAME_SIZE + 7
+           : (mode.power && strLen(mode.name, LUMP_MAX_NAME_SIZE) > LUMP_MAX_SHORT_NAME_SIZE)
+               ? LUMP_MAX_SHORT_NAME_SIZE
+               : strLen(mode.name, LUMP_MAX_NAME_SIZE);
+  }
+
+  /**
+   * Gets a value span of a mode.
+   *
+   * @param mode Mode.
+   * @param slot `HS_SLOT_RAW`, `HS_SLOT_PCT` or `HS_SLOT_SI`.
+   * @return Value span.
+   */
+  constexpr const LumpValueSpan &hsValueSpan(const LumpMode &mode, uint8_t slot) {
+    return (slot == HS_SLOT_RAW) ? mode.raw : (slot == HS_SLOT_PCT) ? mode.pct : mode.si;
+  }
+
+  /**
+   * Gets the payload size of a message of a mode.
+   *
+   * @param mode Mode.
+   * @param slot Message slot (`HandshakeSlot`).
+   * @param numCombos Number of mode combinations sent with the mode.
+   * @return Size of the payload in bytes, or `0` if the message is not sent.
+   */
+  constexpr uint8_t hsModeMsgSize(const LumpMode &mode, uint8_t slot, uint8_t numCombos) {
+    return (slot == HS_SLOT_NAME) ? ((mode.flagsInName || mode.power) ? queryNextPow2(LUMP_MAX_SHORT_NAME_SIZE + 7)
+                                                                       : queryNextPow2(hsNameLen(mode)))
+           : (slot <= HS_SLOT_SI)
+               ? ((hsValueSpan(mode, slot).isExist && hsValueSpan(mode, slot).isValid) ? 8 : 0)
+           : (slot == HS_SLOT_SYMBOL)      ? queryNextPow2(strLen(mode.symbol, LUMP_MAX_UOM_SIZE))
+           : (slot == HS_SLOT_MODE_COMBOS) ? (numCombos ? queryNextPow2(numCombos * 2) : 0)
+                                           : 4;
+  }
+
+  /**
+   * Gets the INFO type of a message slot.
+   *
+   * @param slot Message slot (`HandshakeSlot`).
+   * @return INFO type (`lump_info_type_t`).
+   */
+  constexpr uint8_t hsInfoType(uint8_t slot) {
+    return (slot == HS_SLOT_NAME)          ? LUMP_INFO_NAME
+           : (slot == HS_SLOT_RAW)         ? LUMP_INFO_RAW
+           : (slot == HS_SLOT_PCT)         ? LUMP_INFO_PCT
+           : (slot == HS_SLOT_SI)          ? LUMP_INFO_SI
+           : (slot == HS_SLOT_SYMBOL)      ? LUMP_INFO_UNITS
+           : (slot == HS_SLOT_MODE_COMBOS) ? LUMP_INFO_MODE_COMBOS
+                                           : LUMP_INFO_FORMAT;
+  }
+
+  /**
+   * Gets a payload byte of a message of a mode.
+   *
+   * @param spec Device.
+   * @param mode Mode number.
+   * @param slot Message slot (`HandshakeSlot`).
+   * @param i Byte index.
+   * @return Payload byte.
+   */
+  constexpr uint8_t hsModePayloadAt(const HandshakeSpec &spec, uint8_t mode, uint8_t slot, uint8_t i) {
+    return (slot == HS_SLOT_NAME)
+               ? ((i < hsNameLen(spec.modes[mode])) ? static_cast<uint8_t>(spec.modes[mode].name[i])
+                  : (spec.modes[mode].flagsInName || !spec.modes[mode].power) ? 0
+                  : (i == LUMP_MAX_SHORT_NAME_SIZE + 1)                        ? LUMP_MODE_FLAGS0_NEEDS_SUPPLY_PIN2
+                  : (i == LUMP_MAX_SHORT_NAME_SIZE + 6)                        ? 0x84 // SPIKE3 firmware requires these flags.
+                                                                               : 0)
+           : (slot <= HS_SLOT_SI)
+               ? ((i < 4) ? byteOf(floatBits(hsValueSpan(spec.modes[mode], slot).min), i)
+                          : byteOf(floatBits(hsValueSpan(spec.modes[mode], slot).max), i - 4))
+           : (slot == HS_SLOT_SYMBOL)      ? static_cast<uint8_t>(spec.modes[mode].symbol[i])
+           : (slot == HS_SLOT_MODE_COMBOS) ? ((i / 2 < spec.numCombos) ? byteOf(spec.combos[i / 2], i % 2) : 0)
+           : (i == 0)                      ? spec.modes[mode].numData
+           : (i == 1)                      ? spec.modes[mode].dataType
+           : (i == 2)                      ? spec.modes[mode].figures
+                                           : spec.modes[mode].decimals;
+  }
+
+  /**
+   * Gets the number of messages of a handshake image.
+   *
+   * @param spec Device.
+   * @return Number of message slots, including the ones that are not sent.
+   */
+  constexpr uint8_t hsNumMsgs(const HandshakeSpec &spec) {
+    return HS_NUM_DEVICE_MSGS + spec.numModes * HS_NUM_MODE_SLOTS;
+  }
+
+  /**
+   * Gets the mode of a message. Modes are sent from the last to the first.
+   *
+   * @param spec Device.
+   * @param msg Message index, `HS_NUM_DEVICE_MSGS` or above.
+   * @return Mode number.
+   */
+  constexpr uint8_t hsModeOf(const HandshakeSpec &spec, uint8_t msg) {
+    return spec.numModes - 1 - (msg - HS_NUM_DEVICE_MSGS) / HS_NUM_MODE_SLOTS;
+  }
+
+  /**
+   * Gets the slot of a message.
+   *
+   * @param msg Message index, `HS_NUM_DEVICE_MSGS` or above.
+   * @return Message slot (`HandshakeSlot`).
+   */
+  constexpr uint8_t hsSlotOf(uint8_t msg) {
+    return (msg - HS_NUM_DEVICE_MSGS) % HS_NUM_MODE_SLOTS;
+  }
+
+  /**
+   * Gets the length of a message from its payload size.
+   *
+   * @param size Size of the payload in bytes.
+   * @return Length in bytes (including header, INFO type and checksum), or `0` if the message is not sent.
+   */
+  constexpr uint8_t hsInfoMsgLen(uint8_t size) {
+    return size ? size + 3 : 0;
+  }
+
+  /**
+   * Gets the length of a message.
+   *
+   * @param spec Device.
+   * @param msg Message index.
+   * @return Length in bytes (including header, INFO type and checksum), or `0` if the message is not sent.
+   */
+  constexpr uint8_t hsMsgLen(const HandshakeSpec &spec, uint8_t msg) {
+    return (msg == 0)                 ? 3
+           : (msg == 1)               ? 4
+           : (msg == 2)               ? 6
+           : (msg >= hsNumMsgs(spec)) ? 0
+                                      : hsInfoMsgLen(hsModeMsgSize(spec.modes[hsModeOf(spec, msg)], hsSlotOf(msg),
+                                                                   hsModeOf(spec, msg) ? 0 : spec.numCombos));
+  }
+
+  /**
+   * Gets the highest mode announced to EV3 hosts.
+   *
+   * @param spec Device.
+   * @return Highest mode number, up to `LUMP_MAX_MODE`.
+   */
+  constexpr uint8_t hsEv3MaxMode(const HandshakeSpec &spec) {
+    return (spec.numModes - 1 < LUMP_MAX_MODE) ? spec.numModes - 1 : LUMP_MAX_MODE;
+  }
+
+  /**
+   * Gets a byte of a message, without the checksum.
+   *
+   * @param spec Device.
+   * @param msg Message index.
+   * @param i Byte index, below the length of the message minus 1.
+   * @return Message byte.
+   */
+  constexpr uint8_t hsMsgByteAt(const HandshakeSpec &spec, uint8_t msg, uint8_t i) {
+    return (msg == 0) ? ((i == 0) ? encMsgHeader(LUMP_MSG_TYPE_CMD, 1, LUMP_CMD_TYPE) : spec.type)
+           : (msg == 1) ? ((i == 0)   ? encMsgHeader(LUMP_MSG_TYPE_CMD, 2, LUMP_CMD_MODES)
+                           : (i == 1) ? hsEv3MaxMode(spec)
+                                      : ((static_cast<uint8_t>(spec.view - 1) > hsEv3MaxMode(spec)) ? hsEv3MaxMode(spec)
+                                                                                                    : spec.view - 1))
+           : (msg == 2) ? ((i == 0) ? encMsgHeader(LUMP_MSG_TYPE_CMD, 4, LUMP_CMD_SPEED) : byteOf(spec.speed, i - 1))
+           : (i == 0)   ? encMsgHeader(LUMP_MSG_TYPE_INFO, hsMsgLen(spec, msg) - 3, hsModeOf(spec, msg) % (LUMP_MAX_MODE + 1))
+           : (i == 1)   ? hsInfoType(hsSlotOf(msg)) | LUMP_INFO_MODE(hsModeOf(spec, msg))
+                        : hsModePayloadAt(spec, hsModeOf(spec, msg), hsSlotOf(msg), i - 2);
+  }
+
+  /**
+   * Calculates the checksum of the first bytes of a message, like `calcChecksum()`.
+   *
+   * @param spec Device.
+   * @param msg Message index.
+   * @param size Number of bytes.
+   * @return Checksum.
+   */
+  constexpr uint8_t hsMsgChecksum(const HandshakeSpec &spec, uint8_t msg, uint8_t size) {
+    return size ? hsMsgChecksum(spec, msg, size - 1) ^ hsMsgByteAt(spec, msg, size - 1) : 0xff;
+  }
+
+  /**
+   * Gets the length of a handshake image.
+   *
+   * @param spec Device.
+   * @param msg First message to count (default: `0`).
+   * @return Length in bytes.
+   */
+  constexpr uint16_t hsSerializedLen(const HandshakeSpec &spec, uint8_t msg = 0) {
+    return (msg >= hsNumMsgs(spec)) ? 0 : hsMsgLen(spec, msg) + hsSerializedLen(spec, msg + 1);
+  }
+
+  constexpr uint8_t hsSerializedAt(const HandshakeSpec &spec, uint16_t i, uint8_t msg = 0);
+
+  /**
+   * Gets a byte of a handshake image, once the length of the message that `i` counts from is known.
+   *
+   * @param spec Device.
+   * @param i Byte index.
+   * @param msg Message that `i` counts from.
+   * @param len Length of `msg`.
+   * @return Image byte.
+   */
+  constexpr uint8_t hsSerializedAt(const HandshakeSpec &spec, uint16_t i, uint8_t msg, uint8_t len) {
+    return (i >= len)       ? hsSerializedAt(spec, i - len, msg + 1)
+           : (i == len - 1) ? hsMsgChecksum(spec, msg, i)
+                            : hsMsgByteAt(spec, msg, i);
+  }
+
+  /**
+   * Gets a byte of a handshake image.
+   *
+   * The image holds the messages in the order of the handshake, as recorded by `LumpDevice::writeHandshakeMsg()`.
+   *
+   * @param spec Device.
+   * @param i Byte index.
+   * @param msg Message that `i` counts from (default: `0`).
+   * @return Image byte, or `0` past the end of the image.
+   */
+  constexpr uint8_t hsSerializedAt(const HandshakeSpec &spec, uint16_t i, uint8_t msg) {
+    return (msg >= hsNumMsgs(spec)) ? 0 : hsSerializedAt(spec, i, msg, hsMsgLen(spec, msg));
+  }
+
+  /* Sequence of indices, to expand a handshake image into an initializer list. */
+  template <uint16_t... I>
+  struct IndexSeq {
+      typedef IndexSeq type;
+  };
+
+  template <typename A, typename B>
+  struct JoinIndexSeq;
+
+  template <uint16_t... A, uint16_t... B>
+  struct JoinIndexSeq<IndexSeq<A...>, IndexSeq<B...>> : IndexSeq<A..., static_cast<uint16_t>(sizeof...(A) + B)...> {};
+
+  /**
+   * Makes the index sequence `0, 1, ..., N - 1`.
+   *
+   * Halves `N` at each step, so the template depth stays logarithmic.
+   *
+   * @tparam N Number of indices.
+   */
+  template <uint16_t N>
+  struct MakeIndexSeq : JoinIndexSeq<typename MakeIndexSeq<N / 2>::type, typename MakeIndexSeq<N - N / 2>::type> {};
+
+  template <>
+  struct MakeIndexSeq<0> : IndexSeq<> {};
+
+  template <>
+  struct MakeIndexSeq<1> : IndexSeq<0> {};
+
+} // namespace LumpDeviceBuilder::Internal
+
+namespace LumpDeviceBuilder {
+
+  /**
+   * Represents a handshake image serialized at compile time. See `LUMP_HANDSHAKE_IMAGE()`.
+   *
+   * @tparam Len Length of the image in bytes.
+   */
+  template <uint16_t Len>
+  struct LumpHandshakeImage {
+      uint8_t bytes[Len];
+
+      /**
+       * Serializes the handshake of a device.
+       *
+       * @tparam I Byte indices `0..Len - 1`.
+       * @param spec Device.
+       * @return Handshake image.
+       */
+      template <uint16_t... I>
+      static constexpr LumpHandshakeImage serialize(const Internal::HandshakeSpec &spec, Internal::IndexSeq<I...>) {
+        return LumpHandshakeImage{{Internal::hsSerializedAt(spec, I)...}};
+      }
+  };
+
+  /**
+   * Gets the length of the handshake image of a mode table.
+   *
+   * @tparam N Number of modes.
+   * @param modes Mode table.
+   * @return Length in bytes.
+   */
+  template <size_t N>
+  constexpr uint16_t lumpHandshakeImageLen(const LumpMode (&modes)[N]) {
+    return Internal::hsSerializedLen(Internal::HandshakeSpec{0, 0, 0, modes, Internal::hsNumModes(N), nullptr, 0});
+  }
+
+  /**
+   * Gets the length of the handshake image of a mode table with mode combinations.
+   *
+   * @tparam N Number of modes.
+   * @tparam C Number of mode combinations.
+   * @param modes Mode table.
+   * @param combos Mode combinations.
+   * @return Length in bytes.
+   */
+  template <size_t N, size_t C>
+  constexpr uint16_t lumpHandshakeImageLen(const LumpMode (&modes)[N], const uint16_t (&combos)[C]) {
+    return Internal::hsSerializedLen(
+        Internal::HandshakeSpec{0, 0, 0, modes, Internal::hsNumModes(N), combos, Internal::hsNumCombos(C)}
+    );
+  }
+
+  /**
+   * Serializes the handshake of a device at compile time.
+   *
+   * The arguments are those given to the `LumpDevice` constructor. Prefer `LUMP_HANDSHAKE_IMAGE()`.
+   *
+   * @tparam Len Length of the image. See `lumpHandshakeImageLen()`.
+   * @tparam N Number of modes.
+   * @param type Device type.
+   * @param speed Communication speed.
+   * @param view Number of modes to show in view and data log.
+   * @param modes Mode table.
+   * @return Handshake image.
+   */
+  template <uint16_t Len, size_t N>
+  constexpr LumpHandshakeImage<Len>
+  lumpHandshakeImage(uint8_t type, uint32_t speed, uint8_t view, const LumpMode (&modes)[N]) {
+    return LumpHandshakeImage<Len>::serialize(
+        Internal::HandshakeSpec{type, speed, view, modes, Internal::hsNumModes(N), nullptr, 0},
+        typename Internal::MakeIndexSeq<Len>::type()
+    );
+  }
+
+  /**
+   * Serializes the handshake of a device with mode combinations at compile time.
+   *
+   * The arguments are those given to the `LumpDevice` constructor and `LumpDevice::setModeCombos()`.
+   * Prefer `LUMP_HANDSHAKE_IMAGE()`.
+   *
+   * @tparam Len Length of the image. See `lumpHandshakeImageLen()`.
+   * @tparam N Number of modes.
+   * @tparam C Number of mode combinations.
+   * @param type Device type.
+   * @param speed Communication speed.
+   * @param view Number of modes to show in view and data log.
+   * @param modes Mode table.
+   * @param combos Mode combinations.
+   * @return Handshake image.
+   */
+  template <uint16_t Len, size_t N, size_t C>
+  constexpr LumpHandshakeImage<Len>
+  lumpHandshakeImage(uint8_t type, uint32_t speed, uint8_t view, const LumpMode (&modes)[N], const uint16_t (&combos)[C]) {
+    return LumpHandshakeImage<Len>::serialize(
+        Internal::HandshakeSpec{type, speed, view, modes, Internal::hsNumModes(N), combos, Internal::hsNumCombos(C)},
+        typename Internal::MakeIndexSeq<Len>::type()
+    );
+  }
+
+/**
+ * Defines a handshake image serialized at compile time, placed in flash (`PROGMEM` on AVR).
+ *
+ * The modes (and mode combinations) must be declared `constexpr`. Pass the image to `LumpDevice::setHandshakeImage()`:
+ * ```
+ * LUMP_HANDSHAKE_IMAGE(image, type, speed, view, modes);         // or
+ * LUMP_HANDSHAKE_IMAGE(image, type, speed, view, modes, combos);
+ * ```
+ *
+ * @param name Name of the image.
+ * @param type Device type.
+ * @param speed Communication speed.
+ * @param view Number of modes to show in view and data log.
+ * @param ... Mode table, and optionally the mode combinations.
+ */
+#define LUMP_HANDSHAKE_IMAGE(name, type, speed, view, ...)                                                             \
+  constexpr LumpDeviceBuilder::LumpHandshakeImage<LumpDeviceBuilder::lumpHandshakeImageLen(__VA_ARGS__)>                \
+      name LUMP_PROGMEM = LumpDeviceBuilder::lumpHandshakeImage<LumpDeviceBuilder::lumpHandshakeImageLen(__VA_ARGS__)>( \
+          type, speed, view, __VA_ARGS__                                                                               \
+      )
+
+  /* Represents the send policy of a scheduled mode. */
+  enum class LumpSendPolicy : uint8_t {
+    Periodic, // Sends a data message every period.
+    OnChange, // Sends a data message when a value changes by at least the deadband.
+  };
+
+  /* Represents the policy applied when a queue is full. */
+  enum class LumpOverflowPolicy : uint8_t {
+    DropOldest, // Drops the oldest entry to make room for the new one.
+    DropNewest, // Drops the new entry.
+    Coalesce,   // Replaces the newest entry with the new one.
+  };
+
+  /**
+   * Represents the streaming schedule of a LUMP device mode.
+   *
+   * Like `LumpMode`, schedules are constexpr-constructible and can be declared as a `const` table.
+   */
+  class LumpModeSchedule {
+    public:
+      ~LumpModeSchedule()                                   = default;
+      LumpModeSchedule(const LumpModeSchedule &)            = default;
+      LumpModeSchedule(LumpModeSchedule &&)                 = default;
+      LumpModeSchedule &operator=(const LumpModeSchedule &) = default;
+      LumpModeSchedule &operator=(LumpModeSchedule &&)      = default;
+
+      /**
+       * Creates a streaming schedule.
+       *
+       * @param sampler Callback function that writes the values of `mode` into `data` (zero-initialized, 4-byte
+       *   aligned, `dataMsgSize` bytes). Returns `false` to skip this period. `nullptr` disables the schedule.
+       * @param period Send period in microseconds (default: `0`, sends on every `run()` call).
+       * @param policy Send policy (default: `LumpSendPolicy::Periodic`).
+       * @param deadband Minimum change of a value for `LumpSendPolicy::OnChange` (default: `0`, any change).
+       * @param init Callback function to initialize `mode` (default: `nullptr`). Called in `LumpDeviceState::InitMode`.
+       */
+      constexpr LumpModeSchedule(
+          bool (*sampler)(uint8_t mode, void *data) = nullptr,
+          uint32_t period                           = 0,
+          LumpSendPolicy policy                     = LumpSendPolicy::Periodic,
+          float deadband                            = 0,
+          void (*init)(uint8_t mode)                = nullptr
+      )
+          : sampler{sampler}, period{period}, policy{policy}, deadband{deadband}, init{init} {}
+
+      bool (*sampler)(uint8_t mode, void *data);
+      uint32_t period;
+      LumpSendPolicy policy;
+      float deadband;
+      void (*init)(uint8_t mode);
+  };
+
+  /* Represents a payload passed between threads by the threaded runner. */
+  struct LumpSample {
+      uint8_t mode{0};
+      uint8_t size{0};
+      alignas(4) uint8_t payload[LUMP_MAX_MSG_SIZE]{};
+  };
+
+#if LUMP_LINK_STATS
+  /* Represents the link statistics of a LUMP device. See `LumpDevice::linkStats()`. */
+  struct LumpLinkStats {
+      /* Traffic */
+      uint32_t rxBytes{0};    // Bytes received.
+      uint32_t txBytes{0};    // Bytes queued or written for transmission.
+      uint32_t rxMsgs{0};     // Valid messages received.
+      uint32_t txDataMsgs{0}; // Data messages queued for transmission.
+
+      /* Errors */
+      uint32_t checksumErrors{0}; // Messages discarded for a checksum error.
+      uint32_t invalidSizes{0};   // Message headers discarded for an invalid size.
+      uint32_t nacksSent{0};      // NACKs sent to the host.
+      uint32_t nacksReceived{0};  // NACKs received from the host while communicating.
+      uint32_t nackTimeouts{0};   // Soft resets caused by a NACK timeout.
+
+      /* Handshake */
+      uint32_t handshakes{0};        // Handshakes started.
+      uint32_t handshakeFailures{0}; // Handshakes that timed out waiting for the ACK reply.
+      uint32_t handshakeMillis{0};   // Duration of the last successful handshake (milliseconds).
+
+      /* Timing */
+      uint32_t stateMicros[LUMP_NUM_DEVICE_STATES]{}; // Time spent in each state (microseconds).
+      uint32_t runCount{0};                           // Number of `run()` calls.
+      uint32_t runMinMicros{UINT32_MAX};              // Shortest `run()` call (microseconds).
+      uint32_t runMaxMicros{0};                       // Longest `run()` call (microseconds).
+      uint64_t runTotalMicros{0};                     // Total time spent in `run()` (microseconds).
+
+      /**
+       * Gets the average cost of a `run()` call.
+       *
+       * @return Time in microseconds.
+       */
+      inline uint32_t runAvgMicros() const { return runCount ? runTotalMicros / runCount : 0; }
+  };
+#endif
+
+  /* Represents the event of a trace record. */
+  enum class LumpTraceEvent : uint8_t {
+    State,         // State transition. Argument: new `LumpDeviceState`.
+    RxFrame,       // Message received. Argument: length.
+    TxFrame,       // Message queued for sending. Argument: length.
+    ChecksumError, // Message discarded for a checksum error. Argument: computed checksum. Data: received checksum.
+    InvalidSize,   // Header discarded for an invalid size. Argument: message size.
+    AckTimeout,    // Handshake failed waiting for the ACK reply.
+    NackTimeout,   // Soft reset caused by a NACK timeout.
+    TxDrop,        // Data message dropped because the TX queue was full. Argument: mode.
+  };
+
+  /**
+   * Represents a record of the binary tracer. See `LumpDevice::readTrace()`.
+   *
+   * The layout is fixed (12 bytes, little-endian) so that dumped traces can be decoded on a host
+   * (see `extras/lump_trace.py`).
+   */
+  struct LumpTraceRecord {
+      uint32_t micros{0}; // Timestamp (`LUMP_MICROS()`).
+      LumpTraceEvent event{LumpTraceEvent::State};
+      uint8_t arg{0};    // Argument of the event.
+      uint8_t data[6]{}; // First bytes of the message, zero-padded.
+  };
+
+  static_assert(sizeof(LumpTraceRecord) == 12, "Unexpected trace record layout");
+
+  template <uint8_t N>
+  class LumpHub;
+
+  /**
+   * LUMP device class.
+   *
+   * @tparam T Type of the serial interface (typically `hardwareSerial`).
+   */
+  template <typename T>
+  class LumpDevice {
+      template <uint8_t N>
+      friend class LumpHub;
+
+    public:
+      virtual ~LumpDevice()                     = default;
+      LumpDevice(const LumpDevice &)            = default;
+      LumpDevice(LumpDevice &&)                 = default;
+      LumpDevice &operator=(const LumpDevice &) = default;
+      LumpDevice &operator=(LumpDevice &&)      = default;
+
+      /**
+       * Creates a device.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param uart Serial interface used for UART communication (e.g., `Serial0`, `Serial1`).
+       * @param rxPin RX pin number of the serial interface.
+       * @param txPin TX pin number of the serial interface.
+       * @param type Device type.
+       * @param speed Communication speed.
+       * @param modes Device modes (must be an array of `LumpMode`).
+       * @param numModes Number of modes.
+       *   For SPIKE Hub: `[1..16]`
+       *   For EV3: `[1..8]`
+       *   Modes beyond the limit will be ignored.
+       * @param view Number of modes to show in view and data log (default: `LUMP_VIEW_ALL`).
+       *   Valid range: `[1..16]`.
+       *   Set to `LUMP_VIEW_ALL` to show all modes.
+       * @param fwVersion Firmware version (default: `10000000`).
+       *   Valid range: `[10000000..99999999]`.
+       *   The value `10000000` represents v1.0.00.0000.
+       * @param hwVersion Hardware version (default: `10000000`).
+       *   Valid range: `[10000000..99999999]`.
+       *   The value `10000000` represents v1.0.00.0000.
+       */
+      LumpDevice(
+          T *uart,
+          uint8_t rxPin,
+          uint8_t txPin,
+          uint8_t type,
+          uint32_t speed,
+          const LumpMode *modes,
+          uint8_t numModes,
+          uint8_t view       = LUMP_VIEW_ALL,
+          uint32_t fwVersion = 10000000,
+          uint32_t hwVersion = 10000000
+      );
+
+      /**
+       * Starts the device.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       */
+      void begin();
+
+      /**
+       * Finishes the device.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       */
+      void end();
+
+      /**
+       * Sets the watchdog timer callback functions.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param initWdtCallback Callback function to initialize the watchdog timer.
+       * @param feedWdtCallback Callback function to feed the watchdog timer.
+       * @param deinitWdtCallback Callback function to deinitialize the watchdog timer.
+       */
+      inline void setWdtCallback(void (*initWdtCallback)(), void (*feedWdtCallback)(), void (*deinitWdtCallback)()) {
+        this->initWdtCallback   = initWdtCallback;
+        this->feedWdtCallback   = feedWdtCallback;
+        this->deinitWdtCallback = deinitWdtCallback;
+      }
+
+      /**
+       * Sets the mode combinations.
+       *
+       * The mode combinations are sent with the information of mode 0 during the handshake.
+       * The host can then select a combination and read the data of several modes in a single data message.
+       * See `sendCombo()`.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param combos Array of mode combinations, must remain valid while the device is running.
+       *   Each combination is a bitmask of modes (bit `n` for mode `n`).
+       * @param numCombos Number of mode combinations.
+       *   Valid range: `[0..8]`.
+       *   Combinations beyond the limit will be ignored.
+       */
+      inline void setModeCombos(const uint16_t *combos, uint8_t numCombos) {
+        modeCombos    = combos;
+        numModeCombos = min(numCombos, static_cast<uint8_t>(LUMP_MAX_MODE_COMBOS));
+        hsImageReady  = false;
+      }
+
+      /**
+       * Sets the buffer for the handshake image.
+       *
+       * The first handshake records the serialized mode information into the buffer.
+       * Subsequent handshakes stream the recorded image instead of serializing the information again.
+       * For mode tables known at compile time, prefer the image of `LUMP_HANDSHAKE_IMAGE()`, which needs no RAM.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param image Pointer to the buffer.
+       * @param size Size of the buffer.
+       *   Use `LUMP_HANDSHAKE_IMAGE_SIZE(numModes)` to fit the largest possible image.
+       *   If the image exceeds the buffer, the handshake image is disabled.
+       */
+      inline void setHandshakeImage(uint8_t *image, uint16_t size) {
+        hsImageBuffer  = image;
+        hsImage        = image;
+        hsImageInFlash = false;
+        hsImageSize    = size;
+        hsImageLen     = 0;
+        hsImageIdx     = 0;
+        hsImageEnd     = 0;
+        hsImageReady   = false;
+      }
+
+      /**
+       * Sets a handshake image serialized at compile time. See `LUMP_HANDSHAKE_IMAGE()`.
+       *
+       * Every handshake, including the first one, streams the image from flash.
+       * The image must be built from the same type, speed, view, modes and mode combinations as the device.
+       * An image for another type or number of modes is ignored. While the device advertises another speed than the
+       * image (e.g., lowered by adaptive speed), the handshake is serialized message by message instead.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @tparam Len Length of the image.
+       * @param image Handshake image.
+       */
+      template <uint16_t Len>
+      inline void setHandshakeImage(const LumpHandshakeImage<Len> &image) {
+        setFlashHandshakeImage(image.bytes, Len);
+      }
+
+      /**
+       * Sets the maximum number of bytes processed per `run()` call.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param size Maximum number of bytes (default: `LUMP_RX_BURST_SIZE`).
+       *   Valid range: `[1..255]`.
+       *   Values below `1` will be clamped to `1`.
+       */
+      inline void setRxBurstSize(uint8_t size) { rxBurstSize = size ? size : 1; }
+
+#if LUMP_RX_RING_SIZE > 0
+      /**
+       * Pushes a received byte into the RX ring.
+       *
+       * Interrupt-safe. Intended for UART RX interrupts that read the data register themselves.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param c Received byte.
+       * @note Only available if `LUMP_RX_RING_SIZE` is greater than `0`.
+       *   The ring should hold the bytes received during the longest gap between `run()` calls
+       *   (e.g., 460800 baud delivers about 46 bytes per millisecond).
+       */
+      inline void pushRxByte(uint8_t c) { rxRing.push(c); }
+
+      /**
+       * Moves the bytes received by the serial interface into the RX ring.
+       *
+       * Intended for RX interrupts or callbacks of the core (e.g., `HardwareSerial::onReceive()` on ESP32).
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @note Only available if `LUMP_RX_RING_SIZE` is greater than `0`.
+       */
+      inline void pumpRx() {
+        while (uart->available()) {
+          rxRing.push(uart->read());
+        }
+      }
+
+      /**
+       * Gets the number of received bytes dropped because the RX ring was full.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @return Number of bytes.
+       */
+      inline uint32_t rxRingOverflowCount() { return rxRing.overflows; }
+
+      /**
+       * Gets the highest number of bytes held by the RX ring.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @return Number of bytes.
+       */
+      inline uint32_t rxRingHighWater() { return rxRing.highWater; }
+#endif
+
+#if LUMP_TRACE_SIZE > 0
+      /**
+       * Reads the oldest trace records.
+       *
+       * The tracer records state transitions, received and sent messages and link errors into a RAM ring of
+       * `LUMP_TRACE_SIZE` records. When the ring is full, the oldest records are overwritten.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param records Buffer for the records.
+       * @param maxRecords Maximum number of records to read.
+       * @return Number of records read.
+       * @note Only available if `LUMP_TRACE_SIZE` is greater than `0`.
+       */
+      uint16_t readTrace(LumpTraceRecord *records, uint16_t maxRecords);
+
+      /**
+       * Writes the unread trace records in the dump format to a stream (e.g., `Serial`) and marks them as read.
+       *
+       * Format (little-endian): the `"LTRC"` magic, a version byte (`1`), the record size (`12`), the number of
+       * records (`uint16_t`) and the number of overwritten records (`uint32_t`), followed by the records.
+       * See `extras/lump_trace.py` for a decoder.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @tparam S Type of the stream.
+       * @param out Stream to write to.
+       * @note Only available if `LUMP_TRACE_SIZE` is greater than `0`.
+       */
+      template <typename S>
+      void dumpTrace(S &out);
+
+      /**
+       * Gets the number of trace records overwritten before being read.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @return Number of records.
+       * @note Only available if `LUMP_TRACE_SIZE` is greater than `0`.
+       */
+      inline uint32_t traceLostCount() { return traceLost; }
+#endif
+
+      /**
+       * Sets the interval for re-announcing the extended mode to the host.
+       *
+       * Devices with more than `LUMP_MAX_MODE + 1` modes prefix data messages with an extended mode message.
+       * The prefix is only sent when the extended mode changes, after a reset or NACK, or when the interval has elapsed.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param interval Interval in milliseconds (default: `LUMP_EXT_MODE_REFRESH_INTERVAL`).
+       *   `0` sends the prefix before every data message.
+       */
+      inline void setExtModeRefreshInterval(uint16_t interval) { extModeRefreshInterval = interval; }
+
+      /**
+       * Sets the streaming schedules of the modes.
+       *
+       * While a scheduled mode is active, the device calls its sampler and sends the data messages on its own:
+       * - On schedule, according to the period and send policy of the mode.
+       * - Immediately after a NACK from the host (`hasNack()` is consumed by the scheduler).
+       * - Postponed while the previous data message of the mode is still waiting in the TX queue.
+       *
+       * Modes without a sampler, and combined mode, are left to the sketch.
+       * Periods are timed with `LUMP_MICROS()`, so send rates above 1 kHz can be paced accurately.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param schedules Array of schedules, indexed by mode number.
+       * @param numSchedules Number of schedules. Schedules beyond the number of modes are ignored.
+       */
+      inline void setSchedules(const LumpModeSchedule *schedules, uint8_t numSchedules) {
+        this->schedules    = schedules;
+        this->numSchedules = schedules ? min(numSchedules, numModes) : 0;
+      }
+
+      /**
+       * Runs the device.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       */
+      void run();
+
+      /**
+       * Gets the time until the device next needs `run()` to be called, apart from received bytes.
+       *
+       * Covers the handshake pauses and timeouts, the NACK timeout, scheduled data messages and the TX queue.
+       * Work done by the sketch itself (e.g., unscheduled modes) is not taken into account.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @return Time in microseconds. `0` means `run()` should be called again immediately.
+       */
+      uint32_t timeToNextDeadline();
+
+      /**
+       * Sets the callback function to sleep until the next deadline.
+       *
+       * The callback should put the MCU into a low-power state (e.g., `WFI`, light sleep) and return when the time
+       * has elapsed or when a byte is received by the serial interface.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param sleepCallback Callback function, receiving the sleep time in microseconds.
+       */
+      inline void setSleepCallback(void (*sleepCallback)(uint32_t us)) { this->sleepCallback = sleepCallback; }
+
+      /**
+       * Sets the callback function called when the host selects a mode.
+       *
+       * Called from `run()` while the message is processed, before `LumpDeviceState::InitMode`.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param selectCallback Callback function, receiving the selected mode.
+       */
+      inline void setSelectCallback(void (*selectCallback)(uint8_t mode)) { this->selectCallback = selectCallback; }
+
+      /**
+       * Sets the callback function called when the host sends a `LUMP_CMD_WRITE` message.
+       *
+       * The callback gets a view into the RX buffer, which is only valid during the call.
+       * While the callback is set, the payload is not copied, so `hasCmdWriteData()` stays `false`.
+       * Mode combination setups are handled by the device and not passed to the callback.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param writeCallback Callback function, receiving the payload and its size.
+       */
+      inline void setWriteCallback(void (*writeCallback)(const uint8_t *data, uint8_t size)) {
+        this->writeCallback = writeCallback;
+      }
+
+      /**
+       * Sets the callback function called when the host sends a data message.
+       *
+       * The callback gets a view into the RX buffer, which is only valid during the call, for any mode
+       * (an output mapping is not required). While the callback is set, data messages are not copied,
+       * so `hasDataMsg()` stays `false`.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param dataCallback Callback function, receiving the mode, the payload and its size.
+       */
+      inline void setDataCallback(void (*dataCallback)(uint8_t mode, const uint8_t *data, uint8_t size)) {
+        this->dataCallback = dataCallback;
+      }
+
+      /**
+       * Sets the callback function called when the host sends a NACK.
+       *
+       * `hasNack()` is still set, so the scheduler and the threaded runner keep resending after a NACK.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param nackCallback Callback function.
+       */
+      inline void setNackCallback(void (*nackCallback)()) { this->nackCallback = nackCallback; }
+
+      /**
+       * Sleeps until the next deadline, using the callback set by `setSleepCallback()`.
+       *
+       * Returns immediately if no callback is set, a deadline is due, or received bytes are waiting.
+       * Typically called right after `run()` in `loop()`.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       */
+      void sleep();
+
+      /**
+       * Gets the device state.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @return Device state.
+       * @note With the threaded runner, this is the state published at the end of the last `run()`,
+       *   which may be read from another thread.
+       */
+      inline LumpDeviceState state() {
+#if LUMP_THREADED_RUNNER
+        return static_cast<LumpDeviceState>(__atomic_load_n(&publishedState, __ATOMIC_ACQUIRE));
+#else
+        return deviceState;
+#endif
+      }
+
+      /**
+       * Gets the device mode.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @return Device mode.
+       * @note With the threaded runner, this is the mode published at the end of the last `run()`,
+       *   which may be read from another thread.
+       */
+      inline uint8_t mode() {
+#if LUMP_THREADED_RUNNER
+        return __atomic_load_n(&publishedMode, __ATOMIC_ACQUIRE);
+#else
+        return deviceMode;
+#endif
+      }
+
+      /**
+       * Enables or disables adaptive speed.
+       *
+       * When enabled, the device starts at the speed given to the constructor and tracks checksum errors and NACKs
+       * while communicating. If the link exceeds `LUMP_SPEED_ERROR_LIMIT` checksum errors or `LUMP_SPEED_NACK_LIMIT`
+       * NACKs within `LUMP_SPEED_ERROR_WINDOW` milliseconds, or hits the NACK timeout after checksum or framing errors
+       * since the last NACK, the device soft resets and advertises the next lower speed of the ladder in the next
+       * handshake (see `Internal::lowerUartSpeed()`). A NACK timeout without such errors (e.g., the device has been
+       * unplugged) soft resets at the current speed. The chosen speed persists across soft resets.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param enable Whether to enable adaptive speed.
+       *   Disabling it restores the speed given to the constructor.
+       */
+      inline void setAdaptiveSpeed(bool enable) {
+        adaptiveSpeed = enable;
+        if (!enable && speed != maxSpeed) {
+          speed        = maxSpeed;
+          hsImageReady = false; // The image contains the speed.
+        }
+      }
+
+      /**
+       * Gets the communication speed advertised in the handshake.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @return Speed.
+       */
+      inline uint32_t currentSpeed() { return speed; }
+
+      /**
+       * Gets the number of times adaptive speed has lowered the speed.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @return Number of speed downgrades.
+       */
+      inline uint8_t speedDowngradeCount() { return speedDowngrades; }
+
+      /**
+       * Checks if the device is in communication phase.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @retval true The device is in communication phase.
+       * @retval false Otherwise.
+       */
+      inline bool isCommunicating() { return deviceState >= LumpDeviceState::InitMode; }
+
+      /**
+       * Checks for a newly received NACK.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @retval true A newly received NACK is available.
+       * @retval false Otherwise.
+       * @note This function automatically clears the flag after checking.
+       */
+      bool hasNack();
+
+      /**
+       * Checks for a newly received mode combination selection.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @retval true A newly received mode combination selection is available.
+       * @retval false Otherwise.
+       * @note This function automatically clears the flag after checking.
+       */
+      bool hasComboSelect();
+
+      /**
+       * Checks if a mode combination is selected by the host.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @retval true A mode combination is selected.
+       * @retval false Otherwise.
+       * @note The selection is cleared when the host selects a mode.
+       */
+      inline bool isComboMode() { return numComboEntries > 0; }
+
+      /**
+       * Gets the index of the selected mode combination.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @return Index of the mode combination in the array passed to `setModeCombos()`.
+       */
+      inline uint8_t combo() { return comboIdx; }
+
+      /**
+       * Clears the command write data.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       */
+      void clearCmdWriteData();
+
+      /**
+       * Checks for a newly received command write data.
+       *
+       * Received payloads are queued (up to `LUMP_CMD_WRITE_QUEUE_SIZE`). Each call takes the oldest one, which can
+       * then be read with `readCmdWriteData()`, so `while (device.hasCmdWriteData())` processes them in order.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @retval true A newly received command write data is available.
+       * @retval false Otherwise.
+       * @note This function automatically clears the flag after checking.
+       */
+      bool hasCmdWriteData();
+
+      /**
+       * Gets the size of the command write data taken by `hasCmdWriteData()`.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @return Size in bytes.
+       */
+      inline uint8_t cmdWriteSize() { return cmdWriteDataSize; }
+
+      /**
+       * Gets the reception time of the command write data taken by `hasCmdWriteData()`.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @return Timestamp in milliseconds (`LUMP_MILLIS()`).
+       */
+      inline uint32_t cmdWriteMillis() { return cmdWriteDataMillis; }
+
+      /**
+       * Sets the policy applied when the command write queue is full.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param policy Overflow policy (default: `LumpOverflowPolicy::DropOldest`).
+       */
+      inline void setCmdWriteOverflowPolicy(LumpOverflowPolicy policy) { cmdWritePolicy = policy; }
+
+      /**
+       * Gets the number of command write data dropped or replaced because the queue was full.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @return Number of command write data.
+       */
+      inline uint32_t cmdWriteDropCount() { return cmdWriteDrops; }
+
+      /**
+       * Reads the command write data.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @tparam U Type of the command write data.
+       * @return U* Pointer to the command write data array.
+       */
+      template <typename U>
+      inline U *readCmdWriteData() {
+        return reinterpret_cast<U *>(cmdWriteData);
+      }
+
+      /**
+       * Clears the data message for the specified mode.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param mode Mode number.
+       */
+      void clearDataMsg(uint8_t mode);
+
+      /**
+       * Checks for a newly received data message for the specified mode.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param mode Mode number.
+       * @retval true A newly received data message is available.
+       * @retval false Otherwise.
+       * @note This function automatically clears the flag after checking.
+       */
+      bool hasDataMsg(uint8_t mode);
+
+      /**
+       * Reads the data message of the specified mode.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @tparam U Type of the data.
+       * @param mode Mode number.
+       * @retval U* Pointer to the the data message array if the `mode` is valid and the data message is available.
+       * @retval nullptr Otherwise.
+       */
+      template <typename U>
+      U *readDataMsg(uint8_t mode);
+
+      /**
+       * Sends the data of the selected mode combination.
+       *
+       * The values requested by the host are packed into a single data message of the current mode,
+       * in the order of the selection.
+       * Does nothing if no mode combination is selected.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param data Array of pointers to the data array of each mode, indexed by mode number.
+       *   Pointers of modes that are not in the combination may be `nullptr`.
+       */
+      void sendCombo(const void *const *data);
+
+      /**
+       * Gets the number of bytes required by the data message buffers of all modes.
+       *
+       * Modes with an output mapping (`mapOut`) get a buffer from the data message arena of the device.
+       * If the footprint exceeds `LUMP_DATA_MSG_ARENA_SIZE`, modes that do not fit ignore data messages:
+       * `begin()` reports it in debug builds, and the ignored messages are counted by `rxDataDropCount()`.
+       * Use `lumpDataMsgFootprint()` to check the arena size at compile time.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @return Number of bytes.
+       */
+      inline uint16_t dataMsgFootprint() { return dataMsgArenaFootprint; }
+
+      /**
+       * Gets the number of data messages from the host ignored because their mode has no buffer.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @return Number of ignored data messages.
+       * @note Only counts modes with an output mapping that did not fit in the arena. See `dataMsgFootprint()`.
+       */
+      inline uint32_t rxDataDropCount() { return rxDataDrops; }
+
+      /**
+       * Gets the deadline of the next scheduled data message.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @return Deadline as a `LUMP_MICROS()` timestamp. A deadline in the past means the data message is due.
+       * @note Only meaningful while a scheduled mode is communicating. See `setSchedules()`.
+       */
+      inline uint32_t nextSampleMicros() { return schedMicros; }
+
+      /**
+       * Gets the number of bytes waiting in the TX queue.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @return Number of bytes.
+       */
+      inline uint16_t txQueueDepth() { return txQueueLen; }
+
+      /**
+       * Gets the number of data messages dropped because the TX queue was full.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @return Number of dropped data messages.
+       */
+      inline uint32_t txDropCount() { return txDrops; }
+
+      /**
+       * Gets the number of queued data messages replaced by a newer one of the same mode.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @return Number of replaced data messages.
+       */
+      inline uint32_t txCoalesceCount() { return txCoalesces; }
+
+      /**
+       * Gets the number of bytes saved by suppressing redundant extended mode messages.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @return Number of bytes.
+       */
+      inline uint32_t extModeSavedBytes() { return extModeSaved; }
+
+#if LUMP_LINK_STATS
+      /**
+       * Gets the link statistics.
+       *
+       * Counts the traffic, errors and handshakes, and records the time spent in each `LumpDeviceState` and in `run()`.
+       * Disabled by defining `LUMP_LINK_STATS` as `0`.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @return Link statistics.
+       */
+      inline const LumpLinkStats &linkStats() { return linkStatsData; }
+
+      /**
+       * Resets the link statistics.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       */
+      inline void resetLinkStats() { linkStatsData = LumpLinkStats(); }
+#endif
+
+      /**
+       * Reserves the payload of a data message for the current mode.
+       *
+       * The data can be written directly into the returned payload, then sent with `commit()`.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @tparam U Type of the data.
+       * @return U* Pointer to the payload array (4-byte aligned, up to `LUMP_MAX_MSG_SIZE` bytes).
+       * @warning The payload must be committed before calling `run()` or any other send function.
+       * @note Schedules are paused while a payload is reserved. An uncommitted payload is discarded on reset and mode change.
+       */
+      template <typename U>
+      inline U *reserve() {
+        return reserve<U>(deviceMode);
+      }
 
       /**
-       * Gets the device mode.
+       * Reserves the payload of a data message for a specific mode.
+       *
+       * The data can be written directly into the returned payload, then sent with `commit()`.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @tparam U Type of the data.
+       * @param mode Mode number.
+       * @retval U* Pointer to the payload array (4-byte aligned, up to `LUMP_MAX_MSG_SIZE` bytes) if the `mode` is valid.
+       * @retval nullptr Otherwise.
+       * @warning The payload must be committed before calling `run()` or any other send function.
+       * @note Schedules are paused while a payload is reserved. An uncommitted payload is discarded on reset and mode change.
+       */
+      template <typename U>
+      U *reserve(uint8_t mode);
+
+      /**
+       * Sends the reserved payload as a data message.
+       *
+       * The size of the payload is given by the `dataType` and `numData` of the reserved mode.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       * @return Device mode.
        */
-      inline uint8_t mode() { return deviceMode; }
+      void commit();
 
       /**
-       * Checks if the device is in communication phase.
+       * Sends a data array in a compile-time data format.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @tparam F Data format of the mode (`LumpDataFormat`).
+       * @tparam U Type of the data, must match the data type of `F`.
+       * @tparam N Size of the data array, must match the number of data of `F`.
+       * @param data Reference to the data array.
+       * @param mode Mode number.
+       */
+      template <typename F, typename U, size_t N>
+      inline void sendAs(const U (&data)[N], uint8_t mode) {
+        static_assert(N == F::numData, "Number of data does not match the data format");
+        _sendAs<F>(&data[0], mode);
+      }
+
+      /**
+       * Sends a data value in a compile-time data format.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @tparam F Data format of the mode (`LumpDataFormat`).
+       * @tparam U Type of the data, must match the data type of `F`.
+       * @param data A data value.
+       * @param mode Mode number.
+       */
+      template <typename F, typename U>
+      inline void sendAs(const U &data, uint8_t mode) {
+        static_assert(F::numData == 1, "Number of data does not match the data format");
+        _sendAs<F>(&data, mode);
+      }
+
+      /**
+       * Sends a data array of the specified type.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @tparam U Type of the data.
+       * @param data Pointer to the data array.
+       * @param num Number of data in the data array.
+       */
+      template <typename U>
+      inline void send(U *data, uint8_t num) {
+        sendDataMsg(reinterpret_cast<void *>(data), num * sizeof(U), deviceMode);
+      }
+
+      /**
+       * Sends a data array of the specified type for a specific mode.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @tparam U Type of the data.
+       * @param data Pointer to the data array.
+       * @param num Number of data in the data array.
+       * @param mode Mode number.
+       */
+      template <typename U>
+      inline void send(U *data, uint8_t num, uint8_t mode) {
+        sendDataMsg(reinterpret_cast<void *>(data), num * sizeof(U), mode);
+      }
+
+      /**
+       * Sends a data array of the specified type.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @tparam U Type of the data.
+       * @tparam N Size of the data array.
+       * @param data Pointer to the data array.
+       * @param num Number of data in the data array.
+       */
+      template <typename U, size_t N>
+      inline void send(U (*data)[N], uint8_t num) {
+        sendDataMsg(reinterpret_cast<void *>(data), num * sizeof(U), deviceMode);
+      };
+
+      /**
+       * Sends a data array of the specified type for a specific mode.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @tparam U Type of the data.
+       * @tparam N Size of the data array.
+       * @param data Pointer to the data array.
+       * @param num Number of data in the data array.
+       * @param mode Mode number.
+       */
+      template <typename U, size_t N>
+      inline void send(U (*data)[N], uint8_t num, uint8_t mode) {
+        sendDataMsg(reinterpret_cast<void *>(data), num * sizeof(U), mode);
+      };
+
+      /**
+       * Sends a data value of the specified type.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @tparam U Type of the data.
+       * @param data A data value.
+       */
+      template <typename U>
+      inline void send(U data) {
+        sendDataMsg(reinterpret_cast<void *>(&data), sizeof(U), deviceMode);
+      }
+
+      /**
+       * Sends a data value of the specified type for a specific mode.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @tparam U Type of the data.
+       * @param data A data value.
+       * @param mode Mode number.
+       */
+      template <typename U>
+      inline void send(U data, uint8_t mode) {
+        sendDataMsg(reinterpret_cast<void *>(&data), sizeof(U), mode);
+      }
+
+#if LUMP_THREADED_RUNNER
+      /**
+       * Runs the device from its own thread, core or task.
+       *
+       * Like `run()`, then sends the latest published sample of the current mode.
+       * The sample is resent after a NACK from the host (`hasNack()` is consumed by the runner).
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @note Apart from the publisher methods (`publish()`, `takeDataMsg()`, `takeCmdWrite()`), `state()` and
+       *   `mode()`, other methods must only be called from the thread that runs the device.
+       */
+      void runProtocol();
+
+      /**
+       * Runs the device until `stopProtocolTask()` is called.
+       *
+       * Entry point for a FreeRTOS task (`xTaskCreatePinnedToCore()`) or a `std::thread`. On RP2040, `runProtocol()`
+       * can be called from `loop1()` instead. A stopped task may be started again.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param device Pointer to the device.
+       */
+      static void protocolTask(void *device) {
+        LumpDevice *self = static_cast<LumpDevice *>(device);
+        __atomic_store_n(&self->taskStop, false, __ATOMIC_RELEASE);
+        while (!__atomic_load_n(&self->taskStop, __ATOMIC_ACQUIRE)) {
+          self->runProtocol();
+          LUMP_TASK_YIELD();
+        }
+      }
+
+      /**
+       * Requests the running `protocolTask()` to return.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @note Has no effect on a task that starts afterwards.
+       */
+      inline void stopProtocolTask() { __atomic_store_n(&taskStop, true, __ATOMIC_RELEASE); }
+
+      /**
+       * Publishes a data array for a mode. Wait-free, may be called from another thread.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @tparam U Type of the data.
+       * @param data Pointer to the data array.
+       * @param num Number of data in the data array.
+       * @param mode Mode number.
+       */
+      template <typename U>
+      inline void publish(const U *data, uint8_t num, uint8_t mode) {
+        LumpSample &sample = samples.back();
+        sample.mode        = mode;
+        sample.size        = min(static_cast<size_t>(num * sizeof(U)), sizeof(sample.payload));
+        memcpy(sample.payload, data, sample.size);
+        samples.publish();
+      }
+
+      /**
+       * Publishes a data value for a mode. Wait-free, may be called from another thread.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @tparam U Type of the data.
+       * @param data A data value.
+       * @param mode Mode number.
+       */
+      template <typename U>
+      inline void publish(U data, uint8_t mode) {
+        publish(&data, 1, mode);
+      }
+
+      /**
+       * Takes the latest data message received from the host. Wait-free, may be called from another thread.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param msg Receives the mode, size and payload of the data message.
+       * @retval true A new data message has been taken.
+       * @retval false No data message has been received since the last call.
+       */
+      inline bool takeDataMsg(LumpSample &msg) { return take(hostDataMsgs, msg); }
+
+      /**
+       * Takes the latest `LUMP_CMD_WRITE` payload received from the host. Wait-free, may be called from another thread.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param msg Receives the size and payload of the command (`mode` is the device mode at reception).
+       * @retval true A new payload has been taken.
+       * @retval false No payload has been received since the last call.
+       */
+      inline bool takeCmdWrite(LumpSample &msg) { return take(hostCmdWrites, msg); }
+#endif
+
+    protected:
+#if LUMP_THREADED_RUNNER
+      /**
+       * Takes the latest value of a host-to-application triple buffer.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       */
+      static bool take(Internal::TripleBuffer<LumpSample> &buffer, LumpSample &msg) {
+        if (!buffer.update()) {
+          return false;
+        }
+        msg = buffer.front();
+        return true;
+      }
+
+      /**
+       * Publishes a message received from the host to a host-to-application triple buffer.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       */
+      inline void publishHostMsg(Internal::TripleBuffer<LumpSample> &buffer, uint8_t mode, uint8_t size) {
+        LumpSample &msg = buffer.back();
+        msg.mode        = mode;
+        msg.size        = size;
+        memcpy(msg.payload, &rxBuffer[1], size);
+        buffer.publish();
+      }
+
+      /**
+       * Publishes the device state and mode for `state()` and `mode()`.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       */
+      inline void publishState() {
+        __atomic_store_n(&publishedState, static_cast<uint8_t>(deviceState), __ATOMIC_RELEASE);
+        __atomic_store_n(&publishedMode, deviceMode, __ATOMIC_RELEASE);
+      }
+#endif
+
+      /**
+       * Runs the device state machine.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       */
+      void _run();
+
+      /**
+       * Processes the RX messages.
+       *
+       * Drains up to `rxBurstSize` bytes per call and completes every message within them.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       */
+      void processRxMsg();
+
+      /**
+       * Gets the number of received bytes waiting to be processed.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @return Number of bytes.
+       */
+      inline int rxAvailable() {
+#if LUMP_RX_RING_SIZE > 0
+        return rxRing.available();
+#else
+        return uart->available();
+#endif
+      }
+
+      /**
+       * Reads a received byte.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @return Received byte.
+       */
+      inline uint8_t rxRead() {
+#if LUMP_RX_RING_SIZE > 0
+        return rxRing.pop();
+#else
+        return uart->read();
+#endif
+      }
+
+      /**
+       * Feeds the watchdog timer.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       */
+      void feedWdt();
+
+      /**
+       * Initializes the UART.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param speed Speed.
+       */
+      void initUart(uint32_t speed);
+
+      /**
+       * Writes a message over UART.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param msg A message to write.
+       * @param len Length of the message.
+       */
+      inline void uartWrite(uint8_t *msg, uint8_t len) { uart->write(msg, len); }
+
+      /**
+       * Records an event into the trace ring. Does nothing if `LUMP_TRACE_SIZE` is `0`.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param event Event.
+       * @param arg Argument of the event.
+       * @param data Message, or `nullptr`.
+       * @param len Length of the message. Only the first bytes are recorded.
+       */
+      inline void trace(LumpTraceEvent event, uint8_t arg, const uint8_t *data, uint8_t len) {
+#if LUMP_TRACE_SIZE > 0
+        LumpTraceRecord &record = traceRing[traceHead & (LUMP_TRACE_SIZE - 1)];
+        record.micros           = LUMP_MICROS();
+        record.event            = event;
+        record.arg              = arg;
+        if (len > sizeof(record.data)) {
+          len = sizeof(record.data);
+        }
+        for (uint8_t i = 0; i < sizeof(record.data); ++i) {
+          record.data[i] = (i < len) ? data[i] : 0;
+        }
+        ++traceHead;
+#else
+        (void)event, (void)arg, (void)data, (void)len;
+#endif
+      }
+
+      /**
+       * Records a received or sent message into the trace ring.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param event `LumpTraceEvent::RxFrame` or `LumpTraceEvent::TxFrame`.
+       * @param msg Message.
+       * @param len Length of the message.
+       */
+      inline void traceFrame(LumpTraceEvent event, const uint8_t *msg, uint8_t len) { trace(event, len, msg, len); }
+
+      /**
+       * Records a state transition into the trace ring if the state has changed.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param prevState State before the transition.
+       */
+      inline void traceState(LumpDeviceState prevState) {
+        if (deviceState != prevState) {
+          trace(LumpTraceEvent::State, static_cast<uint8_t>(deviceState), nullptr, 0);
+        }
+      }
+
+      /**
+       * Writes a message over UART.
+       *
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param msg Message to write.
+       */
+      inline void uartWrite(uint8_t msg) { uart->write(msg); }
+
+      /**
+       * Queues a message and writes as much of the TX queue as the UART accepts without blocking.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       * @retval true The device is in communication phase.
-       * @retval false Otherwise.
+       * @param msg A message to write.
+       * @param len Length of the message.
+       * @return `true` if the message has been queued, `false` if the TX queue has no room for it.
+       *   Nothing is written in that case, the caller retries on a later call.
        */
-      inline bool isCommunicating() { return deviceState >= LumpDeviceState::InitMode; }
+      bool txWrite(uint8_t *msg, uint8_t len);
 
       /**
-       * Checks for a newly received NACK.
+       * Checks whether the TX queue has room for a message, after writing as much of it as the UART accepts.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       * @retval true A newly received NACK is available.
-       * @retval false Otherwise.
-       * @note This function automatically clears the flag after checking.
+       * @param len Length of the message.
+       * @return `true` if the message fits.
        */
-      bool hasNack();
+      bool hasTxSpace(uint8_t len);
 
       /**
-       * Clears the command write data.
+       * Appends a message to the TX queue and traces it as `LumpTraceEvent::TxFrame`.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param msg A message to append.
+       * @param len Length of the message.
        */
-      void clearCmdWriteData();
+      void pushTxQueue(uint8_t *msg, uint8_t len);
 
       /**
-       * Checks for a newly received command write data.
+       * Removes written bytes from the TX queue.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       * @retval true A newly received command write data is available.
-       * @retval false Otherwise.
-       * @note This function automatically clears the flag after checking.
+       * @param len Number of bytes to remove.
        */
-      bool hasCmdWriteData();
+      void popTxQueue(uint16_t len);
 
       /**
-       * Reads the command write data.
+       * Writes as much of the TX queue as the UART accepts without blocking.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       * @tparam U Type of the command write data.
-       * @return U* Pointer to the command write data array.
        */
-      template <typename U>
-      inline U *readCmdWriteData() {
-        return reinterpret_cast<U *>(cmdWriteData);
-      }
+      void drainTxQueue();
 
       /**
-       * Clears the data message for the specified mode.
+       * Writes the entire TX queue in blocking mode.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       * @param mode Mode number.
        */
-      void clearDataMsg(uint8_t mode);
+      void flushTxQueue();
 
       /**
-       * Checks for a newly received data message for the specified mode.
+       * Writes a handshake message over UART and records it into the handshake image.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       * @param mode Mode number.
-       * @retval true A newly received data message is available.
-       * @retval false Otherwise.
-       * @note This function automatically clears the flag after checking.
+       * @param msg A message to write.
+       * @param len Length of the message.
+       * @return `true` if the message has been queued. See `txWrite()`.
        */
-      bool hasDataMsg(uint8_t mode);
+      bool writeHandshakeMsg(uint8_t *msg, uint8_t len);
 
       /**
-       * Reads the data message of the specified mode.
+       * Selects the next messages of the handshake image to stream.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       * @tparam U Type of the data.
-       * @param mode Mode number.
-       * @retval U* Pointer to the the data message array if the `mode` is valid and the data message is available.
-       * @retval nullptr Otherwise.
+       * @param numMsgs Number of messages to select.
+       *   Set to `0` to select all messages of the current mode.
        */
-      template <typename U>
-      U *readDataMsg(uint8_t mode);
+      void selectHandshakeImage(uint8_t numMsgs);
 
       /**
-       * Sends a data array of the specified type.
+       * Streams the selected messages of the handshake image, as many whole messages as the TX queue accepts.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       * @tparam U Type of the data.
-       * @param data Pointer to the data array.
-       * @param num Number of data in the data array.
+       * @return `true` if the whole selection has been queued, `false` if the rest must be streamed on a later call.
        */
-      template <typename U>
-      inline void send(U *data, uint8_t num) {
-        sendDataMsg(reinterpret_cast<void *>(data), num * sizeof(U), deviceMode);
-      }
+      bool streamHandshakeImage();
 
       /**
-       * Sends a data array of the specified type for a specific mode.
+       * Sets a handshake image in flash, after checking that it matches the device.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       * @tparam U Type of the data.
-       * @param data Pointer to the data array.
-       * @param num Number of data in the data array.
-       * @param mode Mode number.
+       * @param image Pointer to the image.
+       * @param len Length of the image.
        */
-      template <typename U>
-      inline void send(U *data, uint8_t num, uint8_t mode) {
-        sendDataMsg(reinterpret_cast<void *>(data), num * sizeof(U), mode);
-      }
+      void setFlashHandshakeImage(const uint8_t *image, uint16_t len);
 
       /**
-       * Sends a data array of the specified type.
+       * Reads a byte of the handshake image.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       * @tparam U Type of the data.
-       * @tparam N Size of the data array.
-       * @param data Pointer to the data array.
-       * @param num Number of data in the data array.
+       * @param i Byte index.
+       * @return Image byte.
        */
-      template <typename U, size_t N>
-      inline void send(U (*data)[N], uint8_t num) {
-        sendDataMsg(reinterpret_cast<void *>(data), num * sizeof(U), deviceMode);
-      };
+      inline uint8_t hsImageAt(uint16_t i) { return hsImageInFlash ? LUMP_READ_PROGMEM_BYTE(&hsImage[i]) : hsImage[i]; }
 
       /**
-       * Sends a data array of the specified type for a specific mode.
+       * Sends a value span.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       * @tparam U Type of the data.
-       * @tparam N Size of the data array.
-       * @param data Pointer to the data array.
-       * @param num Number of data in the data array.
-       * @param mode Mode number.
+       * @param valueSpan Reference to the value span (LumpValueSpan).
+       * @param valueType Type of value span.
+       *   Possible values: `LUMP_INFO_RAW`, `LUMP_INFO_PCT`, `LUMP_INFO_SI`.
        */
-      template <typename U, size_t N>
-      inline void send(U (*data)[N], uint8_t num, uint8_t mode) {
-        sendDataMsg(reinterpret_cast<void *>(data), num * sizeof(U), mode);
-      };
+      void sendValueSpan(const LumpValueSpan &valueSpan, uint8_t valueType);
 
       /**
-       * Sends a data value of the specified type.
+       * Sends a data message to the host.
+       *
+       * The message is queued. If a queued message of the same mode has not started to be written yet,
+       * it is replaced. If the TX queue is full, the message is dropped.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       * @tparam U Type of the data.
-       * @param data A data value.
+       * @param payload Pointer to the payload array.
+       * @param len Number of data in the payload array.
+       * @param mode Mode number.
        */
-      template <typename U>
-      inline void send(U data) {
-        sendDataMsg(reinterpret_cast<void *>(&data), sizeof(U), deviceMode);
-      }
+      void sendDataMsg(void *payload, uint8_t len, uint8_t mode);
 
       /**
-       * Sends a data value of the specified type for a specific mode.
+       * Sends the payload in the data message TX buffer to the host.
+       *
+       * Fills the header, zero-pads the payload to the message size and calculates the checksum.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       * @tparam U Type of the data.
-       * @param data A data value.
+       * @param len Size of the payload.
        * @param mode Mode number.
        */
-      template <typename U>
-      inline void send(U data, uint8_t mode) {
-        sendDataMsg(reinterpret_cast<void *>(&data), sizeof(U), mode);
-      }
+      void commitDataMsg(uint8_t len, uint8_t mode);
 
-    protected:
       /**
-       * Runs the device state machine.
+       * Runs the streaming schedule of the current mode.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
        */
-      void _run();
+      void runSchedule();
 
       /**
-       * Processes the RX messages.
+       * Queues the `LUMP_CMD_WRITE` payload in the RX buffer.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param size Size of the payload.
        */
-      void processRxMsg();
+      void queueCmdWrite(uint8_t size);
 
       /**
-       * Feeds the watchdog timer.
+       * Gets the number of values a mode combination holds.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param combo Index of the mode combination.
+       * @return Sum of the number of data of the modes in the combination, or `0` if the index is invalid.
        */
-      void feedWdt();
+      uint8_t comboCapacity(uint8_t combo);
 
       /**
-       * Initializes the UART.
+       * Records a link error for adaptive speed.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       * @param speed Speed.
+       * @param isNack Whether the error is a NACK from the host (otherwise a checksum or framing error).
        */
-      void initUart(uint32_t speed);
+      void recordLinkError(bool isNack);
 
       /**
-       * Writes a message over UART.
+       * Lowers the speed to the next step of the ladder, if adaptive speed is enabled.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       * @param msg A message to write.
-       * @param len Length of the message.
+       * @retval true The speed has been lowered.
+       * @retval false Otherwise.
        */
-      inline void uartWrite(uint8_t *msg, uint8_t len) { uart->write(msg, len); }
+      bool lowerSpeed();
 
       /**
-       * Writes a message over UART.
+       * Gets the data message buffer of a mode.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       * @param msg Message to write.
+       * @param mode Mode number.
+       * @retval void* Pointer to the buffer if the `mode` is valid and has a buffer.
+       * @retval nullptr Otherwise.
        */
-      inline void uartWrite(uint8_t msg) { uart->write(msg); }
+      inline void *dataMsgBuffer(uint8_t mode) {
+        return (mode < numModes && dataMsgOffset[mode] != UINT8_MAX) ? &dataMsgArena[dataMsgOffset[mode]] : nullptr;
+      }
 
       /**
-       * Sends a value span.
+       * Sends a data array in a compile-time data format.
+       *
+       * `F` must match the `dataType` and `numData` of the mode. This is not checked in release builds;
+       * debug builds (`LUMP_DEBUG_SERIAL`) print an error and drop the message instead.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       * @param valueSpan Reference to the value span (LumpValueSpan).
-       * @param valueType Type of value span.
-       *   Possible values: `LUMP_INFO_RAW`, `LUMP_INFO_PCT`, `LUMP_INFO_SI`.
+       * @tparam F Data format of the mode (`LumpDataFormat`).
+       * @tparam U Type of the data, must match the data type of `F`.
+       * @param data Pointer to the data array, with `F::numData` data.
+       * @param mode Mode number.
        */
-      void sendValueSpan(const LumpValueSpan &valueSpan, uint8_t valueType);
+      template <typename F, typename U>
+      void _sendAs(const U *data, uint8_t mode);
 
       /**
-       * Sends a data message to the host.
+       * Queues the data message in the data message TX buffer.
        *
        * @tparam T Type of the serial interface (typically `hardwareSerial`).
-       * @param payload Pointer to the payload array.
-       * @param len Number of data in the payload array.
+       * @param msgLen Length of the message.
        * @param mode Mode number.
        */
-      void sendDataMsg(void *payload, uint8_t len, uint8_t mode);
+      void queueDataMsg(uint8_t msgLen, uint8_t mode);
 
       /**
        * Initializes the watchdog timer.
@@ -534,6 +2479,19 @@ namespace LumpDeviceBuilder {
        */
       void (*deinitWdtCallback)() = nullptr;
 
+      /**
+       * Callback function to sleep until the next deadline.
+       */
+      void (*sleepCallback)(uint32_t us) = nullptr;
+
+      /**
+       * Callback functions for host messages.
+       */
+      void (*selectCallback)(uint8_t mode)                                  = nullptr;
+      void (*writeCallback)(const uint8_t *data, uint8_t size)              = nullptr;
+      void (*dataCallback)(uint8_t mode, const uint8_t *data, uint8_t size) = nullptr;
+      void (*nackCallback)()                                                = nullptr;
+
       /* UART */
       T *uart;
       uint8_t rxPin;
@@ -542,7 +2500,8 @@ namespace LumpDeviceBuilder {
       /* Device info */
       uint8_t type;
       uint32_t speed;
-      LumpMode *modes;
+      uint32_t maxSpeed;
+      const LumpMode *modes;
       uint8_t numModes;
       uint8_t view;
       uint32_t fwVersion;
@@ -561,83 +2520,349 @@ namespace LumpDeviceBuilder {
       LumpDeviceState prevDeviceState{LumpDeviceState::InitWdt};
       LumpReceiverState receiverState{LumpReceiverState::ReadByte};
 
+      /* UART capability */
+      int txCapacity{0};
+      uint32_t txByteMicros{0}; // Time to transmit one byte at the current speed.
+
       /* Timing */
       uint32_t currentMillis;
+      uint32_t currentMicros;
       uint32_t prevMillis;
       uint32_t nackMillis;
 
       /* TX */
       uint8_t txBuffer[LUMP_UART_BUFFER_SIZE]{};
 
+      /* Data message TX buffer */
+      alignas(4) uint8_t dataTxBuffer[LUMP_DATA_TX_OFFSET + LUMP_UART_BUFFER_SIZE]{};
+      uint8_t reservedMode{UINT8_MAX};
+
+      /* TX queue */
+      static_assert(LUMP_TX_QUEUE_SIZE >= LUMP_UART_BUFFER_SIZE + 3, "LUMP_TX_QUEUE_SIZE is too small");
+      uint8_t txQueue[LUMP_TX_QUEUE_SIZE]{};
+      uint16_t txQueueHead{0};
+      uint16_t txQueueLen{0};
+      int16_t txDataOffset{-1}; // Offset of the last queued data message, or -1 if none.
+      uint8_t txDataMode{0};
+      uint8_t txDataLen{0};
+      uint32_t txDrops{0};
+      uint32_t txCoalesces{0};
+
+      /* Extended mode announcement */
+      uint8_t announcedExtMode{UINT8_MAX}; // Extended mode last announced to the host, or `UINT8_MAX` if unknown.
+      uint32_t extModeMillis{0};
+      uint16_t extModeRefreshInterval{LUMP_EXT_MODE_REFRESH_INTERVAL};
+      uint32_t extModeSaved{0};
+
+      /* Adaptive speed */
+      bool adaptiveSpeed{false};
+      uint32_t linkWindowMillis{0};
+      uint32_t linkErrorMillis{0}; // Time of the last checksum or framing error.
+      uint8_t linkErrors{0};
+      uint8_t linkNacks{0};
+      uint8_t speedDowngrades{0};
+
+#if LUMP_TRACE_SIZE > 0
+      /* Tracer */
+      static_assert((LUMP_TRACE_SIZE & (LUMP_TRACE_SIZE - 1)) == 0 && LUMP_TRACE_SIZE <= 32768,
+                    "LUMP_TRACE_SIZE must be a power of two up to 32768");
+      LumpTraceRecord traceRing[LUMP_TRACE_SIZE];
+      uint32_t traceHead{0}; // Number of records written.
+      uint32_t traceTail{0}; // Number of records read or overwritten.
+      uint32_t traceLost{0};
+#endif
+
+#if LUMP_LINK_STATS
+      /* Link statistics */
+      LumpLinkStats linkStatsData;
+      LumpDeviceState statsState{LumpDeviceState::InitWdt}; // State at the end of the last `run()`.
+      uint32_t statsMicros{0};                              // Start of the last `run()`.
+      uint32_t handshakeStartMillis{0};
+#endif
+
+      /* Streaming scheduler */
+      const LumpModeSchedule *schedules{nullptr};
+      uint8_t numSchedules{0};
+      uint32_t schedMicros{0}; // Deadline of the next sample.
+      bool schedForce{false};  // Sends the next sample regardless of the send policy.
+      alignas(4) uint8_t schedPayload[LUMP_MAX_MSG_SIZE]{}; // Last payload sent by the scheduler.
+
+      /* Handshake image */
+      uint8_t *hsImageBuffer{nullptr}; // Buffer the handshake is recorded into.
+      const uint8_t *hsImage{nullptr};  // Image to stream, either `hsImageBuffer` or an image in flash.
+      bool hsImageInFlash{false};
+      uint32_t hsImageSpeed{0}; // Speed advertised by an image in flash.
+      uint16_t hsImageSize{0};
+      uint16_t hsImageLen{0};
+      uint16_t hsImageIdx{0}; // Next byte to stream.
+      uint16_t hsImageEnd{0}; // End of the selected messages.
+      bool hsImageReady{false};
+
       /* RX */
       uint8_t rxBuffer[LUMP_UART_BUFFER_SIZE]{};
       uint8_t rxLen{0};
       uint8_t rxIdx{0};
+      uint8_t rxBurstSize{LUMP_RX_BURST_SIZE};
+#if LUMP_RX_RING_SIZE > 0
+      Internal::SpscRing<LUMP_RX_RING_SIZE> rxRing;
+#endif
+
+#if LUMP_THREADED_RUNNER
+      /* Threaded runner */
+      Internal::TripleBuffer<LumpSample> samples;       // Application to device.
+      Internal::TripleBuffer<LumpSample> hostDataMsgs;  // Device to application.
+      Internal::TripleBuffer<LumpSample> hostCmdWrites; // Device to application.
+      bool taskStop{false};
+      uint8_t publishedState{0}; // `deviceState` at the end of the last `run()`.
+      uint8_t publishedMode{0};  // `deviceMode` at the end of the last `run()`.
+#endif
       bool _hasNack{false};
 
+      /* Mode combinations */
+      const uint16_t *modeCombos{nullptr};
+      uint8_t numModeCombos{0};
+      uint8_t comboIdx{0};
+      uint8_t comboEntries[LUMP_MAX_MSG_SIZE - 2]{}; // Mode (high nibble) and dataset (low nibble) of each value.
+      uint8_t numComboEntries{0};
+      bool _hasComboSelect{false};
+
+      /* Data message arena */
+      static_assert(LUMP_DATA_MSG_ARENA_SIZE <= UINT8_MAX, "LUMP_DATA_MSG_ARENA_SIZE is too large");
+      alignas(4) uint8_t dataMsgArena[LUMP_DATA_MSG_ARENA_SIZE]{};
+      uint16_t dataMsgArenaFootprint{0};
+      uint32_t rxDataDrops{0};
+      uint8_t dataMsgOffset[LUMP_MAX_EXT_MODE + 1]{}; // Offset of each mode in the arena, or `UINT8_MAX` if none.
+      uint16_t dataMsgFlags{0};                       // Bit `n` is set if a new data message for mode `n` is available.
+
       /* Command write message */
-      uint8_t cmdWriteData[LUMP_MAX_MSG_SIZE]{};
+      alignas(4) uint8_t cmdWriteData[LUMP_MAX_MSG_SIZE]{};
       uint8_t cmdWriteDataSize{0};
-      bool _hasCmdWriteData{false};
+      uint32_t cmdWriteDataMillis{0};
+
+      /* Command write queue */
+      struct CmdWrite {
+          alignas(4) uint8_t data[LUMP_MAX_MSG_SIZE];
+          uint32_t millis;
+          uint8_t size;
+      };
+
+      static_assert(LUMP_CMD_WRITE_QUEUE_SIZE > 0 && LUMP_CMD_WRITE_QUEUE_SIZE <= UINT8_MAX, "Invalid queue size");
+      CmdWrite cmdWrites[LUMP_CMD_WRITE_QUEUE_SIZE]{};
+      uint8_t cmdWriteHead{0};
+      uint8_t cmdWriteLen{0};
+      LumpOverflowPolicy cmdWritePolicy{LumpOverflowPolicy::DropOldest};
+      uint32_t cmdWriteDrops{0};
   };
 
 } // namespace LumpDeviceBuilder
 
-/* Internal namespace for the LUMP Device Builder Library. */
-namespace LumpDeviceBuilder::Internal {
+namespace LumpDeviceBuilder {
 
   /**
-   * Converts a decimal version number to BCD format.
+   * Represents the data format of a LUMP device mode at compile time.
    *
-   * @param version Version number.
-   * @return Version number in BCD format.
-   */
-  uint32_t versionToBcd(uint32_t version);
-
-  /**
-   * Calculates the checksum of a message.
+   * The sizes and the message header are constant, so `LumpDevice::sendAs()` only copies the data
+   * and calculates the checksum.
    *
-   * @param msg Pointer to the message.
-   * @param size Size of the message.
-   * @return Checksum of the message.
+   * @tparam DataType Data type.
+   *   Possible values: `DATA8`, `DATA16`, `DATA32`, `DATAF`.
+   * @tparam NumData Number of data.
+   *   The maximum depends on `DataType` due to 32-byte payload limit.
    */
-  uint8_t calcChecksum(uint8_t *msg, uint8_t size);
+  template <uint8_t DataType, uint8_t NumData>
+  struct LumpDataFormat {
+      static constexpr uint8_t dataType     = DataType;
+      static constexpr uint8_t numData      = NumData;
+      static constexpr uint8_t dataTypeSize = Internal::sizeOfLumpDataType(DataType);
+      static constexpr size_t payloadSize   = static_cast<size_t>(dataTypeSize) * NumData; // Not truncated.
+      static constexpr uint8_t msgSize      = Internal::queryNextPow2(payloadSize <= LUMP_MAX_MSG_SIZE ? payloadSize : 0);
+      static constexpr uint8_t msgHeader    = Internal::encMsgHeader(LUMP_MSG_TYPE_DATA, msgSize, 0);
+
+      static_assert(dataTypeSize > 0, "Invalid data type");
+      static_assert(NumData > 0 && payloadSize <= LUMP_MAX_MSG_SIZE, "Payload exceeds LUMP_MAX_MSG_SIZE");
+  };
 
   /**
-   * Queries size of the LUMP data type.
+   * Hub of several LUMP devices, e.g., one MCU emulating a sensor on each of its UARTs.
    *
-   * @param dataType LUMP data type.
-   * @return Size of the data type in bytes.
-   */
-  uint8_t sizeOfLumpDataType(uint8_t dataType);
-
-  /**
-   * Queries log2 (up to 32).
+   * The hub runs its devices round-robin, rotating the first device on every `run()` call and sharing the RX budget,
+   * so a busy port cannot starve the others. Handshakes of different ports interleave, as every device state is
+   * non-blocking. The deadlines of all devices are combined into one `timeToNextDeadline()`.
    *
-   * @param x Value to query.
-   * @return Base-2 logarithm of `x`.
-   */
-  uint8_t queryLog2(uint8_t x);
-
-  /**
-   * Queries the next power of 2 (up to 32).
+   * Devices may use different serial interface types. The hub only keeps type-erased pointers to them.
    *
-   * @param x Value to query.
-   * @return Smallest power of 2 greater than or equal to `x`.
+   * @tparam N Maximum number of devices.
    */
-  uint8_t queryNextPow2(uint8_t x);
+  template <uint8_t N>
+  class LumpHub {
+    public:
+      /**
+       * Adds a device to the hub.
+       *
+       * @tparam N Maximum number of devices.
+       * @tparam T Type of the serial interface (typically `hardwareSerial`).
+       * @param device Device to add.
+       * @retval true The device has been added.
+       * @retval false The hub is full.
+       */
+      template <typename T>
+      bool add(LumpDevice<T> &device);
+
+      /**
+       * Starts all devices.
+       *
+       * @tparam N Maximum number of devices.
+       */
+      void begin();
+
+      /**
+       * Finishes all devices.
+       *
+       * @tparam N Maximum number of devices.
+       */
+      void end();
+
+      /**
+       * Runs all devices once, round-robin.
+       *
+       * @tparam N Maximum number of devices.
+       */
+      void run();
+
+      /**
+       * Gets the time until any device next needs `run()` to be called, apart from received bytes.
+       *
+       * @tparam N Maximum number of devices.
+       * @return Time in microseconds. `0` means `run()` should be called again immediately.
+       */
+      uint32_t timeToNextDeadline();
+
+      /**
+       * Sets the callback function to sleep until the next deadline of any device.
+       *
+       * @tparam N Maximum number of devices.
+       * @param sleepCallback Callback function, receiving the sleep time in microseconds.
+       *   It should return early when a byte is received by any of the serial interfaces.
+       */
+      inline void setSleepCallback(void (*sleepCallback)(uint32_t us)) { this->sleepCallback = sleepCallback; }
+
+      /**
+       * Sleeps until the next deadline of any device. See `LumpDevice::sleep()`.
+       *
+       * @tparam N Maximum number of devices.
+       */
+      void sleep();
+
+      /**
+       * Sets the maximum number of bytes processed per `run()` call, shared by all devices.
+       *
+       * @tparam N Maximum number of devices.
+       * @param budget Maximum number of bytes. Each device gets an equal share of at least `1` byte.
+       */
+      void setRxBudget(uint16_t budget);
+
+      /**
+       * Gets the number of devices.
+       *
+       * @tparam N Maximum number of devices.
+       * @return Number of devices.
+       */
+      inline uint8_t numDevices() { return numPorts; }
+
+      /**
+       * Gets the longest time between two consecutive runs of the same device since the last `resetStats()`.
+       *
+       * Measured per port, from the start of one run of the device to the start of its next run, so it includes the
+       * time spent running the other ports and the rotation of the run order. This is the worst-case latency of a port
+       * to react to its host.
+       *
+       * @tparam N Maximum number of devices.
+       * @return Time in microseconds.
+       */
+      inline uint32_t maxServiceGap() { return maxGap; }
+
+      /**
+       * Resets the statistics.
+       *
+       * @tparam N Maximum number of devices.
+       */
+      inline void resetStats() {
+        maxGap = 0;
+        memset(serviced, 0, sizeof(serviced));
+      }
+
+    protected:
+      /* Type-erased operations on a device */
+      struct PortOps {
+          void (*begin)(void *device);
+          void (*end)(void *device);
+          void (*run)(void *device);
+          uint32_t (*timeToNextDeadline)(void *device);
+          int (*rxAvailable)(void *device);
+          void (*setRxBurstSize)(void *device, uint8_t size);
+      };
+
+      template <typename T>
+      struct PortOpsOf {
+          static void begin(void *device) { static_cast<LumpDevice<T> *>(device)->begin(); }
+          static void end(void *device) { static_cast<LumpDevice<T> *>(device)->end(); }
+          static void run(void *device) { static_cast<LumpDevice<T> *>(device)->run(); }
+          static uint32_t timeToNextDeadline(void *device) {
+            return static_cast<LumpDevice<T> *>(device)->timeToNextDeadline();
+          }
+          static int rxAvailable(void *device) { return static_cast<LumpDevice<T> *>(device)->rxAvailable(); }
+          static void setRxBurstSize(void *device, uint8_t size) {
+            static_cast<LumpDevice<T> *>(device)->setRxBurstSize(size);
+          }
+
+          static const PortOps ops;
+      };
+
+      /* Ports */
+      void *devices[N]{};
+      const PortOps *ops[N]{};
+      uint8_t numPorts{0};
+      uint8_t firstPort{0}; // Device that runs first in the next `run()` call.
+
+      /* Sleep */
+      void (*sleepCallback)(uint32_t us) = nullptr;
+
+      /* Statistics */
+      uint32_t lastServiced[N]{}; // Start of the last run of each device.
+      bool serviced[N]{};         // Whether `lastServiced` is valid.
+      uint32_t maxGap{0};
+  };
+
+  template <uint8_t N>
+  template <typename T>
+  const typename LumpHub<N>::PortOps LumpHub<N>::PortOpsOf<T>::ops = {
+      &PortOpsOf<T>::begin,
+      &PortOpsOf<T>::end,
+      &PortOpsOf<T>::run,
+      &PortOpsOf<T>::timeToNextDeadline,
+      &PortOpsOf<T>::rxAvailable,
+      &PortOpsOf<T>::setRxBurstSize,
+  };
+
+} // namespace LumpDeviceBuilder
+
+namespace LumpDeviceBuilder::Internal {
 
   /**
-   * Encodes a message header.
+   * Checks if a type matches a LUMP data type.
    *
-   * @param msgType Message type (`lump_msg_type_t`).
-   * @param size Size of the payload.
-   * @param cmd Command or mode number (`lump_cmd_t`).
-   * @return Encoded message header.
+   * @tparam U Type of the data.
+   * @tparam DataType LUMP data type.
    */
-  inline uint8_t encMsgHeader(uint8_t msgType, uint8_t size, uint8_t cmd) {
-    return msgType | (queryLog2(size) << LUMP_MSG_SIZE_SHIFT) | cmd;
-  }
+  template <typename U, uint8_t DataType>
+  struct isLumpDataType {
+      static constexpr bool value = sizeof(U) == sizeOfLumpDataType(DataType) && DataType != LUMP_DATA_TYPE_DATAF;
+  };
+
+  template <uint8_t DataType>
+  struct isLumpDataType<float, DataType> {
+      static constexpr bool value = DataType == LUMP_DATA_TYPE_DATAF;
+  };
 
 } // namespace LumpDeviceBuilder::Internal
 
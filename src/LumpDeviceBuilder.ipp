@@ -16,7 +16,7 @@ namespace LumpDeviceBuilder {
       uint8_t txPin,
       uint8_t type,
       uint32_t speed,
-      LumpMode *modes,
+      const LumpMode *modes,
       uint8_t numModes,
       uint8_t view,
       uint32_t fwVersion,
@@ -27,20 +27,46 @@ namespace LumpDeviceBuilder {
         txPin{txPin},
         type{type},
         speed{speed},
+        maxSpeed{speed},
         modes{modes},
         view{view},
         fwVersion{fwVersion},
         hwVersion{hwVersion} {
     this->numModes = min(numModes, static_cast<uint8_t>(LUMP_MAX_EXT_MODE + 1));
+
+    /* Assigns the data message buffers from the arena. */
+    uint16_t arenaLen = 0;
+    for (uint8_t i = 0; i < this->numModes; ++i) {
+      dataMsgOffset[i] = UINT8_MAX;
+
+      if (modes[i].mapOut != LUMP_INFO_MAPPING_NONE) {
+        uint16_t size = (modes[i].dataMsgSize + 3) & ~3; // Keeps every buffer 4-byte aligned.
+
+        if (arenaLen + size <= sizeof(dataMsgArena)) {
+          dataMsgOffset[i] = arenaLen;
+          arenaLen += size;
+        }
+        dataMsgArenaFootprint += size;
+      }
+    }
   }
 
   template <typename T>
   void LumpDevice<T>::begin() {
     LUMP_DEBUG_BEGIN(LUMP_DEBUG_SPEED);
 
+    if (dataMsgArenaFootprint > sizeof(dataMsgArena)) {
+      LUMP_DEBUG_PRINT("[Error] LUMP_DATA_MSG_ARENA_SIZE is too small, required: ");
+      LUMP_DEBUG_PRINTLN(dataMsgArenaFootprint);
+    }
+
     deviceState     = LumpDeviceState::InitWdt;
     prevDeviceState = LumpDeviceState::InitWdt;
     receiverState   = LumpReceiverState::ReadByte;
+
+#if LUMP_THREADED_RUNNER
+    publishState();
+#endif
   }
 
   template <typename T>
@@ -57,15 +83,132 @@ namespace LumpDeviceBuilder {
 
   template <typename T>
   void LumpDevice<T>::run() {
-    currentMillis = millis();
+    currentMillis = LUMP_MILLIS();
+    currentMicros = LUMP_MICROS();
+
+#if LUMP_LINK_STATS
+    /* The time since the last call is spent in the state it left. */
+    linkStatsData.stateMicros[static_cast<uint8_t>(statsState)] += currentMicros - statsMicros;
+    statsMicros = currentMicros;
+#endif
+
+    LumpDeviceState entryState = deviceState;
     _run();
+    traceState(entryState);
+
+    entryState = deviceState;
     processRxMsg();
+    traceState(entryState);
+
+    drainTxQueue();
+
+#if LUMP_LINK_STATS
+    uint32_t cost = LUMP_MICROS() - currentMicros;
+    statsState    = deviceState;
+    ++linkStatsData.runCount;
+    linkStatsData.runTotalMicros += cost;
+    linkStatsData.runMinMicros = min(linkStatsData.runMinMicros, cost);
+    linkStatsData.runMaxMicros = max(linkStatsData.runMaxMicros, cost);
+#endif
+
+#if LUMP_THREADED_RUNNER
+    publishState();
+#endif
+  }
+
+#if LUMP_THREADED_RUNNER
+  template <typename T>
+  void LumpDevice<T>::runProtocol() {
+    run();
+
+    bool isNew = samples.update();
+    if (deviceState != LumpDeviceState::Communicating || !(isNew || _hasNack)) {
+      return;
+    }
+
+    const LumpSample &sample = samples.front();
+    if (sample.mode == deviceMode && sample.size) {
+      _hasNack = false;
+      sendDataMsg(const_cast<uint8_t *>(sample.payload), sample.size, sample.mode);
+    }
+  }
+#endif
+
+  template <typename T>
+  uint32_t LumpDevice<T>::timeToNextDeadline() {
+    uint32_t nowMillis = LUMP_MILLIS();
+    uint32_t deadline; // Deadline in milliseconds. The state machine fires once the elapsed time exceeds the delay.
+
+    switch (deviceState) {
+      case LumpDeviceState::WaitingAutoId:
+        deadline = prevMillis + LUMP_AUTO_ID_DELAY + 1;
+        break;
+      case LumpDeviceState::WaitingUartInit:
+        deadline = prevMillis + LUMP_UART_INIT_DELAY + 1;
+        break;
+      case LumpDeviceState::InterModePause:
+        deadline = prevMillis + LUMP_INTER_MODE_PAUSE + 1;
+        break;
+      case LumpDeviceState::WaitingTxDrain:
+        return txByteMicros;
+      case LumpDeviceState::WaitingAckReply:
+        deadline = prevMillis + LUMP_ACK_TIMEOUT + 1;
+        break;
+      case LumpDeviceState::Communicating:
+        deadline = nackMillis + LUMP_NACK_TIMEOUT + 1;
+        break;
+      default:
+        return 0; // The state has work to do right away.
+    }
+
+    if (static_cast<int32_t>(deadline - nowMillis) <= 0) {
+      return 0;
+    }
+    uint32_t timeout = (deadline - nowMillis) * 1000UL;
+
+    if (txQueueLen) {
+      /* Bytes are waiting for space in the TX buffer, which frees up one byte at a time. */
+      timeout = min(timeout, txByteMicros);
+    }
+
+    if (deviceState == LumpDeviceState::Communicating && deviceMode < numSchedules && schedules[deviceMode].sampler &&
+        !numComboEntries) {
+      uint32_t nowMicros = LUMP_MICROS();
+      if (static_cast<int32_t>(schedMicros - nowMicros) > 0) {
+        timeout = min(timeout, schedMicros - nowMicros);
+      } else if (txDataOffset < 0 || txDataMode != deviceMode) {
+        return 0; // Otherwise the sample is postponed until the TX queue drains.
+      }
+    }
+
+    return timeout;
+  }
+
+  template <typename T>
+  void LumpDevice<T>::sleep() {
+    if (!sleepCallback || rxAvailable()) {
+      return;
+    }
+
+    uint32_t timeout = timeToNextDeadline();
+    if (timeout) {
+      sleepCallback(timeout);
+    }
   }
 
   template <typename T>
   void LumpDevice<T>::_run() {
     using namespace LumpDeviceBuilder::Internal;
 
+    /**
+     * Handshake states wait until the TX queue has room for everything they send (at most `LUMP_UART_BUFFER_SIZE` bytes),
+     * so the handshake never blocks, even at `LUMP_UART_SPEED_MIN`. They run on a later call instead.
+     */
+    if (deviceState >= LumpDeviceState::SendingType && deviceState <= LumpDeviceState::SendingFormat &&
+        !hasTxSpace(LUMP_UART_BUFFER_SIZE)) {
+      return;
+    }
+
     /* Device state machine */
     switch (deviceState) {
       /* Initialization phase */
@@ -88,16 +231,28 @@ namespace LumpDeviceBuilder {
         LUMP_DEBUG_PRINTLN("[State] Reset");
 
         feedWdt();
-        deviceMode = 0;
-        extMode    = 0;
-        _hasNack   = false;
-        isLpf2Host = false;
+        deviceMode       = 0;
+        extMode          = 0;
+        _hasNack         = false;
+        isLpf2Host       = false;
+        announcedExtMode = UINT8_MAX;
+        linkErrors       = 0;
+        linkNacks        = 0;
+        linkWindowMillis = currentMillis;
+
+        numComboEntries = 0;
+        _hasComboSelect = false;
+        reservedMode    = UINT8_MAX;
         clearCmdWriteData();
         for (uint8_t i = 0; i < numModes; ++i) {
           clearDataMsg(i);
         }
 
         deviceState = LumpDeviceState::InitAutoId;
+#if LUMP_LINK_STATS
+        ++linkStatsData.handshakes;
+        handshakeStartMillis = currentMillis;
+#endif
 
         LUMP_DEBUG_PRINTLN("[Info] Starting handshake...");
         break;
@@ -131,8 +286,8 @@ namespace LumpDeviceBuilder {
         initUart(LUMP_UART_SPEED_LPF2);
 #endif
 
-        pinMode(txPin, OUTPUT);
-        digitalWrite(txPin, LOW);
+        LUMP_PIN_MODE(txPin, OUTPUT);
+        LUMP_DIGITAL_WRITE(txPin, LOW);
 
         prevMillis  = currentMillis;
         deviceState = LumpDeviceState::WaitingAutoId;
@@ -195,24 +350,48 @@ namespace LumpDeviceBuilder {
 
             txBuffer[0] = LUMP_SYS_ACK;
 
-            LUMP_DEBUG_PRINT_TX_BUFFER(txBuffer, 1);
-            uartWrite(txBuffer, 1);
+            txWrite(txBuffer, 1);
           }
 
+          hsImageIdx  = 0;
+          hsImageEnd  = 0;
+          modeIdx     = numModes - 1; // Start from the last mode.
           deviceState = LumpDeviceState::SendingType;
+          if (hsImageInFlash) {
+            hsImageReady = speed == hsImageSpeed; // An image in flash holds a single speed.
+          }
         }
         break;
 
       case LumpDeviceState::SendingType:
-        /* Sends the device type. */
+        /**
+         * Sends the device type.
+         *
+         * If the handshake image is ready, streams the device type, modes and speed from it instead,
+         * then transitions to `LumpDeviceState::SendingName`.
+         */
+        if (hsImageReady) {
+          if (hsImageIdx == hsImageEnd) {
+            LUMP_DEBUG_PRINTLN("[State] Sending type (image)");
+            selectHandshakeImage(3);
+          }
+          if (streamHandshakeImage()) {
+            deviceState = LumpDeviceState::SendingName;
+          }
+          break;
+        }
+
         LUMP_DEBUG_PRINTLN("[State] Sending type");
 
+        if (!hsImageInFlash) {
+          hsImageLen = 0; // Records the handshake image from scratch.
+        }
+
         txBuffer[0] = encMsgHeader(LUMP_MSG_TYPE_CMD, 1, LUMP_CMD_TYPE);
         txBuffer[1] = type;
         txBuffer[2] = calcChecksum(txBuffer, 2);
 
-        LUMP_DEBUG_PRINT_TX_BUFFER(txBuffer, 3);
-        uartWrite(txBuffer, 3);
+        writeHandshakeMsg(txBuffer, 3);
 
         deviceState = LumpDeviceState::SendingModes;
         break;
@@ -230,8 +409,7 @@ namespace LumpDeviceBuilder {
         txBuffer[2] = (maxView > ev3MaxMode) ? ev3MaxMode : maxView;
         txBuffer[3] = calcChecksum(txBuffer, 3);
 
-        LUMP_DEBUG_PRINT_TX_BUFFER(txBuffer, 4);
-        uartWrite(txBuffer, 4);
+        writeHandshakeMsg(txBuffer, 4);
 
         deviceState = LumpDeviceState::SendingSpeed;
         break;
@@ -245,11 +423,8 @@ namespace LumpDeviceBuilder {
         memcpy(&txBuffer[1], &speed, 4);
         txBuffer[5] = calcChecksum(txBuffer, 5);
 
-        LUMP_DEBUG_PRINT_TX_BUFFER(txBuffer, 6);
-        uartWrite(txBuffer, 6);
+        writeHandshakeMsg(txBuffer, 6);
 
-        // Prepare to send mode information.
-        modeIdx     = numModes - 1; // Start from the last mode.
         deviceState = LumpDeviceState::SendingName;
         break;
 
@@ -271,15 +446,32 @@ namespace LumpDeviceBuilder {
         memcpy(&txBuffer[5], &hwVersionBcd, 4);
         txBuffer[9] = calcChecksum(txBuffer, 9);
 
-        LUMP_DEBUG_PRINT_TX_BUFFER(txBuffer, 10);
-        uartWrite(txBuffer, 10);
+        writeHandshakeMsg(txBuffer, 10);
 
         deviceState = LumpDeviceState::SendingName;
         break;
       }
 
       case LumpDeviceState::SendingName: {
-        /* Sends the mode name and flags. */
+        /**
+         * Sends the mode name and flags.
+         *
+         * If the handshake image is ready, streams all information of the mode from it instead,
+         * then transitions to `LumpDeviceState::SendingFormat`.
+         */
+        if (hsImageReady) {
+          if (hsImageIdx == hsImageEnd) {
+            LUMP_DEBUG_PRINT("[INFO] Sends mode ");
+            LUMP_DEBUG_PRINTLN(modeIdx);
+            LUMP_DEBUG_PRINTLN("[State] Sending name (image)");
+            selectHandshakeImage(0);
+          }
+          if (streamHandshakeImage()) {
+            deviceState = LumpDeviceState::SendingFormat;
+          }
+          break;
+        }
+
         LUMP_DEBUG_PRINT("[INFO] Sends mode ");
         LUMP_DEBUG_PRINTLN(modeIdx);
         LUMP_DEBUG_PRINTLN("[State] Sending name");
@@ -305,8 +497,7 @@ namespace LumpDeviceBuilder {
         memcpy(&txBuffer[2], modes[modeIdx].name, nameLen);
         txBuffer[msgSize + 2] = calcChecksum(txBuffer, msgSize + 2);
 
-        LUMP_DEBUG_PRINT_TX_BUFFER(txBuffer, msgSize + 3);
-        uartWrite(txBuffer, msgSize + 3);
+        writeHandshakeMsg(txBuffer, msgSize + 3);
 
         deviceState = LumpDeviceState::SendingValueSpans;
         break;
@@ -337,11 +528,10 @@ namespace LumpDeviceBuilder {
           memcpy(&txBuffer[2], modes[modeIdx].symbol, symbolLen);
           txBuffer[msgSize + 2] = calcChecksum(txBuffer, msgSize + 2);
 
-          LUMP_DEBUG_PRINT_TX_BUFFER(txBuffer, msgSize + 3);
-          uartWrite(txBuffer, msgSize + 3);
+          writeHandshakeMsg(txBuffer, msgSize + 3);
         }
 
-        deviceState = LumpDeviceState::SendingFormat;
+        deviceState = LumpDeviceState::SendingModeCombos;
         break;
       }
 
@@ -362,12 +552,37 @@ namespace LumpDeviceBuilder {
         txBuffer[3] = modes[modeIdx].mapOut; // see note 1
         txBuffer[4] = calcChecksum(txBuffer, 4);
 
-        LUMP_DEBUG_PRINT_TX_BUFFER(txBuffer, 5);
-        uartWrite(txBuffer, 5);
+        writeHandshakeMsg(txBuffer, 5);
 
         deviceState = LumpDeviceState::SendingFormat;
         break;
 
+      case LumpDeviceState::SendingModeCombos: {
+        /**
+         * Sends the mode combinations.
+         *
+         * Notes:
+         * - Mode combinations are only sent with the information of mode 0.
+         *   See: https://github.com/pybricks/technical-info/blob/88a708c/uart-protocol.md#info_mode_combos
+         */
+        if (modeIdx == 0 && numModeCombos > 0) {
+          LUMP_DEBUG_PRINTLN("[State] Sending mode combos");
+
+          uint8_t msgSize = queryNextPow2(numModeCombos * 2);
+
+          memset(txBuffer, 0, sizeof(txBuffer));
+          txBuffer[0] = encMsgHeader(LUMP_MSG_TYPE_INFO, msgSize, 0);
+          txBuffer[1] = LUMP_INFO_MODE_COMBOS;
+          memcpy(&txBuffer[2], modeCombos, numModeCombos * 2);
+          txBuffer[msgSize + 2] = calcChecksum(txBuffer, msgSize + 2);
+
+          writeHandshakeMsg(txBuffer, msgSize + 3);
+        }
+
+        deviceState = LumpDeviceState::SendingFormat;
+        break;
+      }
+
       case LumpDeviceState::SendingFormat:
         /**
          * Sends the data format.
@@ -376,24 +591,28 @@ namespace LumpDeviceBuilder {
          * - If there are remaining modes to send,
          *   transition to `LumpDeviceState::InterModePause` to prepare for the next mode.
          * - If all modes have been sent,
-         *   transition to `LumpDeviceState::SendingAck` to finalize the handshake sequence.
+         *   transition to `LumpDeviceState::WaitingTxDrain` to finalize the handshake sequence.
+         *
+         * If the handshake image is ready, the format has already been streamed in `LumpDeviceState::SendingName`.
          */
         LUMP_DEBUG_PRINTLN("[State] Sending format");
 
-        txBuffer[0] = encMsgHeader(LUMP_MSG_TYPE_INFO, 4, modeIdx % (LUMP_MAX_MODE + 1));
-        txBuffer[1] = LUMP_INFO_FORMAT | LUMP_INFO_MODE(modeIdx);
-        txBuffer[2] = modes[modeIdx].numData;
-        txBuffer[3] = modes[modeIdx].dataType;
-        txBuffer[4] = modes[modeIdx].figures;
-        txBuffer[5] = modes[modeIdx].decimals;
-        txBuffer[6] = calcChecksum(txBuffer, 6);
+        if (!hsImageReady) {
+          txBuffer[0] = encMsgHeader(LUMP_MSG_TYPE_INFO, 4, modeIdx % (LUMP_MAX_MODE + 1));
+          txBuffer[1] = LUMP_INFO_FORMAT | LUMP_INFO_MODE(modeIdx);
+          txBuffer[2] = modes[modeIdx].numData;
+          txBuffer[3] = modes[modeIdx].dataType;
+          txBuffer[4] = modes[modeIdx].figures;
+          txBuffer[5] = modes[modeIdx].decimals;
+          txBuffer[6] = calcChecksum(txBuffer, 6);
 
-        LUMP_DEBUG_PRINT_TX_BUFFER(txBuffer, 7);
-        uartWrite(txBuffer, 7);
+          writeHandshakeMsg(txBuffer, 7);
+        }
 
         feedWdt();
         if (modeIdx == 0) {
-          deviceState = LumpDeviceState::SendingAck;
+          hsImageReady = hsImageBuffer != nullptr; // The recorded image is complete if nothing overflowed.
+          deviceState  = LumpDeviceState::WaitingTxDrain;
         } else {
           LUMP_DEBUG_PRINTLN("[State] Inter-mode pause");
 
@@ -413,18 +632,38 @@ namespace LumpDeviceBuilder {
         }
         break;
 
+      case LumpDeviceState::WaitingTxDrain:
+        /**
+         * Waits for the TX buffer to drain.
+         *
+         * Waits until all mode information has left the TX queue and the TX buffer, so that the `LUMP_ACK_TIMEOUT` starts
+         * counting when the ACK is actually sent.
+         *
+         * Notes:
+         * - If the serial interface cannot report its free TX space (no `availableForWrite()`), falls back to a blocking
+         *   `flush()`. The TX queue is then written in blocking mode as well, so `run()` still blocks during the handshake
+         *   for such interfaces: up to ~270 ms for a 64-byte TX buffer at 2400 baud (see `bench/RESULTS.md`).
+         */
+        if (txQueueLen) {
+          break;
+        } else if (txCapacity <= 0) {
+          uart->flush();
+        } else if (availableForWrite(uart, 0) < txCapacity) {
+          break;
+        }
+
+        deviceState = LumpDeviceState::SendingAck;
+        break;
+
       case LumpDeviceState::SendingAck:
         /* Sends an ACK to notify the host that all information has been sent and is ready for communication. */
         LUMP_DEBUG_PRINTLN("[State] Sending ACK");
 
-        uart->flush(); // FIXME: Ensure non-blocking behavior.
-
         txBuffer[0] = LUMP_SYS_ACK;
 
-        LUMP_DEBUG_PRINT_TX_BUFFER(txBuffer, 1);
-        uartWrite(txBuffer, 1);
+        txWrite(txBuffer, 1);
 
-        prevMillis  = millis();
+        prevMillis  = currentMillis;
         deviceState = LumpDeviceState::WaitingAckReply;
 
         LUMP_DEBUG_PRINTLN("[State] Waiting for ACK reply...");
@@ -441,6 +680,8 @@ namespace LumpDeviceBuilder {
          */
         if (currentMillis - prevMillis > LUMP_ACK_TIMEOUT) {
           LUMP_DEBUG_PRINTLN("[Error] Handshake failed");
+          LUMP_LINK_STATS_INC(handshakeFailures);
+          trace(LumpTraceEvent::AckTimeout, 0, nullptr, 0);
           deviceState = LumpDeviceState::Reset;
         }
         break;
@@ -470,6 +711,14 @@ namespace LumpDeviceBuilder {
         LUMP_DEBUG_PRINT("[State] Init Mode: ");
         LUMP_DEBUG_PRINTLN(deviceMode);
 
+        /* A payload reserved for the previous mode is discarded, so that the schedule can resume. */
+        reservedMode = UINT8_MAX;
+        if (deviceMode < numSchedules && schedules[deviceMode].init) {
+          schedules[deviceMode].init(deviceMode);
+        }
+        schedMicros = currentMicros;
+        schedForce  = true;
+
         nackMillis  = currentMillis;
         deviceState = LumpDeviceState::Communicating;
         break;
@@ -487,20 +736,30 @@ namespace LumpDeviceBuilder {
           LUMP_DEBUG_PRINTLN("[Error] NACK timeout");
           LUMP_DEBUG_PRINTLN("[Info] Soft reset...");
 
+          if (linkErrors && static_cast<int32_t>(linkErrorMillis - nackMillis) >= 0) {
+            lowerSpeed(); // Only garbled bytes arrived since the last NACK. The current speed may be too high.
+          }
+          LUMP_LINK_STATS_INC(nackTimeouts);
+          trace(LumpTraceEvent::NackTimeout, 0, nullptr, 0);
           deviceState = LumpDeviceState::Reset;
+          break;
         }
+
+        runSchedule();
         break;
 
       case LumpDeviceState::SendingNack:
         /**
          * Sends a NACK to notify the host that the received message is invalid.
          */
-        LUMP_DEBUG_PRINTLN("[State] Sending NACK");
-
         txBuffer[0] = LUMP_SYS_NACK;
 
-        LUMP_DEBUG_PRINT_TX_BUFFER(txBuffer, 1);
-        uartWrite(txBuffer, 1);
+        if (!txWrite(txBuffer, 1)) {
+          break; // Retries once the TX queue has room.
+        }
+
+        LUMP_DEBUG_PRINTLN("[State] Sending NACK");
+        LUMP_LINK_STATS_INC(nacksSent);
 
         deviceState = prevDeviceState;
         break;
@@ -514,179 +773,260 @@ namespace LumpDeviceBuilder {
   void LumpDevice<T>::processRxMsg() {
     using namespace LumpDeviceBuilder::Internal;
 
-    switch (receiverState) {
-      case LumpReceiverState::ReadByte: {
-        /* Reads a byte. */
-        if (!uart->available()) {
-          break;
-        }
+    /**
+     * Drains the received bytes in bursts.
+     *
+     * The receiver state machine keeps stepping until:
+     * - No more bytes are available.
+     * - `rxBurstSize` bytes have been read in this call.
+     * - A message changed the device state, which must be handled by `_run()` first.
+     */
+    uint8_t rxBudget                 = rxBurstSize;
+    const LumpDeviceState entryState = deviceState;
+
+    while (deviceState == entryState) {
+      switch (receiverState) {
+        case LumpReceiverState::ReadByte: {
+          /* Reads a byte. */
+          if (!rxBudget || !rxAvailable()) {
+            return;
+          }
+
+          --rxBudget;
+          rxBuffer[rxIdx] = rxRead();
+          LUMP_LINK_STATS_INC(rxBytes);
 
-        rxBuffer[rxIdx] = uart->read();
+          if (rxIdx == 0) {
+            receiverState = LumpReceiverState::ParseMsgType;
+          } else if (rxIdx >= rxLen - 1) {
+            receiverState = LumpReceiverState::VerityChecksum;
+          }
 
-        if (rxIdx == 0) {
-          receiverState = LumpReceiverState::ParseMsgType;
-        } else if (rxIdx >= rxLen - 1) {
-          receiverState = LumpReceiverState::VerityChecksum;
+          ++rxIdx;
+          break;
         }
 
-        ++rxIdx;
-        break;
-      }
+        case LumpReceiverState::ParseMsgType: {
+          /* Parses the message type. */
+          if (rxBuffer[0] == LUMP_SYS_SYNC || rxBuffer[0] == LUMP_SYS_NACK || rxBuffer[0] == LUMP_SYS_ACK) {
+            /* System message */
+            rxIdx         = 0;
+            rxLen         = 1;
+            receiverState = LumpReceiverState::ProcessMsg;
+            break;
+          }
 
-      case LumpReceiverState::ParseMsgType: {
-        /* Parses the message type. */
-        if (rxBuffer[0] == LUMP_SYS_SYNC || rxBuffer[0] == LUMP_SYS_NACK || rxBuffer[0] == LUMP_SYS_ACK) {
-          /* System message */
-          rxIdx         = 0;
-          rxLen         = 1;
-          receiverState = LumpReceiverState::ProcessMsg;
+          uint8_t msgSize = LUMP_MSG_SIZE(rxBuffer[0]);
+          if (msgSize <= LUMP_MAX_MSG_SIZE) {
+            /* Other types of message */
+            rxLen = msgSize + 2; // +2 for command byte and check byte.
+          } else {
+            /* Invalid message size. Discard this message byte. */
+            LUMP_DEBUG_PRINT("[RX] | invalid size: ");
+            LUMP_DEBUG_PRINTLN(msgSize);
+            trace(LumpTraceEvent::InvalidSize, msgSize, rxBuffer, 1);
+            LUMP_LINK_STATS_INC(invalidSizes);
+
+            if (deviceState == LumpDeviceState::Communicating) {
+              recordLinkError(false); // Framing error.
+            }
+            rxIdx = 0;
+          }
+          receiverState = LumpReceiverState::ReadByte;
           break;
         }
 
-        uint8_t msgSize = LUMP_MSG_SIZE(rxBuffer[0]);
-        if (msgSize <= LUMP_MAX_MSG_SIZE) {
-          /* Other types of message */
-          rxLen = msgSize + 2; // +2 for command byte and check byte.
-        } else {
-          /* Invalid message size. Discard this message byte. */
-          LUMP_DEBUG_PRINT_RX_BUFFER(rxBuffer, 1);
-          LUMP_DEBUG_PRINT("| invalid size: ");
-          LUMP_DEBUG_PRINTLN(msgSize);
-          rxIdx = 0;
-        }
-        receiverState = LumpReceiverState::ReadByte;
-        break;
-      }
+        case LumpReceiverState::VerityChecksum: {
+          /* Verifies the checksum of the message. */
+          uint8_t checksum = calcChecksum(rxBuffer, rxLen - 1);
 
-      case LumpReceiverState::VerityChecksum: {
-        /* Verifies the checksum of the message. */
-        uint8_t checksum = calcChecksum(rxBuffer, rxLen - 1);
+          if (checksum == rxBuffer[rxLen - 1]) {
+            receiverState = LumpReceiverState::ProcessMsg;
+          } else {
+            LUMP_DEBUG_PRINT("[RX] | checksum error: ");
+            LUMP_DEBUG_PRINTLN(checksum);
+            trace(LumpTraceEvent::ChecksumError, checksum, &rxBuffer[rxLen - 1], 1);
+            LUMP_LINK_STATS_INC(checksumErrors);
 
-        if (checksum == rxBuffer[rxLen - 1]) {
-          receiverState = LumpReceiverState::ProcessMsg;
-        } else {
-          LUMP_DEBUG_PRINT_RX_BUFFER(rxBuffer, rxLen);
-          LUMP_DEBUG_PRINT("| checksum error: ");
-          LUMP_DEBUG_PRINTLN(checksum);
+            if (deviceState == LumpDeviceState::Communicating) {
+              recordLinkError(false);
+            }
 
-          prevDeviceState = deviceState;
-          deviceState     = LumpDeviceState::SendingNack;
-          receiverState   = LumpReceiverState::ReadByte;
+            prevDeviceState = deviceState;
+            deviceState     = LumpDeviceState::SendingNack;
+            receiverState   = LumpReceiverState::ReadByte;
+          }
+          rxIdx = 0;
+          break;
         }
-        rxIdx = 0;
-        break;
-      }
 
-      case LumpReceiverState::ProcessMsg: {
-        /* Processes the message. */
-        LUMP_DEBUG_PRINT_RX_BUFFER(rxBuffer, rxLen);
-
-        uint8_t msgType = rxBuffer[0] & LUMP_MSG_TYPE_MASK;
-        uint8_t msgSize = LUMP_MSG_SIZE(rxBuffer[0]);
-        uint8_t msgCmd  = rxBuffer[0] & LUMP_MSG_CMD_MASK; // cmd or mode
-
-        switch (msgType) {
-          case LUMP_MSG_TYPE_SYS:
-            switch (msgCmd) {
-              case LUMP_SYS_SYNC:
-                LUMP_DEBUG_PRINTLN("| SYNC");
-                break;
-              case LUMP_SYS_NACK:
-                LUMP_DEBUG_PRINTLN("| NACK");
-
-                if (deviceState == LumpDeviceState::Communicating) {
-                  feedWdt();
-                  _hasNack   = true;
-                  nackMillis = currentMillis;
-                }
-                break;
-              case LUMP_SYS_ACK:
-                LUMP_DEBUG_PRINTLN("| ACK");
-
-                if (deviceState == LumpDeviceState::WaitingAckReply) {
-                  LUMP_DEBUG_PRINTLN("[Info] Handshake success");
-                  deviceState = LumpDeviceState::SwitchingUartSpeed;
-                }
-                break;
-              default:
-                LUMP_DEBUG_PRINTLN("| unknown");
-                break;
-            }
-            break;
-          case LUMP_MSG_TYPE_CMD:
-            switch (msgCmd) {
-              case LUMP_CMD_SPEED:
-                if (deviceState == LumpDeviceState::WaitingAutoId) {
-                  LUMP_DEBUG_PRINT("| speed: ");
-                  LUMP_DEBUG_PRINTLN(reinterpret_cast<uint32_t *>(&rxBuffer[1])[0]);
-                  LUMP_DEBUG_PRINTLN("[Info] LPF2 host detected");
-
-                  isLpf2Host  = true;
-                  deviceState = LumpDeviceState::InitUart;
-                }
-                break;
-              case LUMP_CMD_SELECT:
-                if (deviceState == LumpDeviceState::Communicating) {
-                  deviceMode  = rxBuffer[1];
-                  deviceState = LumpDeviceState::InitMode;
-
-                  LUMP_DEBUG_PRINT("| select mode: ");
-                  LUMP_DEBUG_PRINTLN(deviceMode);
-                }
-                break;
-              case LUMP_CMD_WRITE:
-                if (deviceState == LumpDeviceState::Communicating) {
-                  if (msgSize <= sizeof(cmdWriteData)) {
-                    cmdWriteDataSize = msgSize;
-                    memcpy(cmdWriteData, &rxBuffer[1], msgSize);
-                    _hasCmdWriteData = true;
+        case LumpReceiverState::ProcessMsg: {
+          /* Processes the message. */
+          LUMP_DEBUG_PRINT("[RX] ");
+          traceFrame(LumpTraceEvent::RxFrame, rxBuffer, rxLen);
+          LUMP_LINK_STATS_INC(rxMsgs);
+
+          uint8_t msgType = rxBuffer[0] & LUMP_MSG_TYPE_MASK;
+          uint8_t msgSize = LUMP_MSG_SIZE(rxBuffer[0]);
+          uint8_t msgCmd  = rxBuffer[0] & LUMP_MSG_CMD_MASK; // cmd or mode
+
+          switch (msgType) {
+            case LUMP_MSG_TYPE_SYS:
+              switch (msgCmd) {
+                case LUMP_SYS_SYNC:
+                  LUMP_DEBUG_PRINTLN("| SYNC");
+                  break;
+                case LUMP_SYS_NACK:
+                  LUMP_DEBUG_PRINTLN("| NACK");
+
+                  if (deviceState == LumpDeviceState::Communicating) {
+                    feedWdt();
+                    LUMP_LINK_STATS_INC(nacksReceived);
+                    _hasNack         = true;
+                    nackMillis       = currentMillis;
+                    announcedExtMode = UINT8_MAX; // The host may have lost the last extended mode message.
+                    recordLinkError(true);
+
+                    if (nackCallback) {
+                      nackCallback();
+                    }
+                  }
+                  break;
+                case LUMP_SYS_ACK:
+                  LUMP_DEBUG_PRINTLN("| ACK");
+
+                  if (deviceState == LumpDeviceState::WaitingAckReply) {
+                    LUMP_DEBUG_PRINTLN("[Info] Handshake success");
+#if LUMP_LINK_STATS
+                    linkStatsData.handshakeMillis = currentMillis - handshakeStartMillis;
+#endif
+                    deviceState = LumpDeviceState::SwitchingUartSpeed;
                   }
+                  break;
+                default:
+                  LUMP_DEBUG_PRINTLN("| unknown");
+                  break;
+              }
+              break;
+            case LUMP_MSG_TYPE_CMD:
+              switch (msgCmd) {
+                case LUMP_CMD_SPEED:
+                  if (deviceState == LumpDeviceState::WaitingAutoId) {
+                    LUMP_DEBUG_PRINT("| speed: ");
+                    LUMP_DEBUG_PRINTLN(reinterpret_cast<uint32_t *>(&rxBuffer[1])[0]);
+                    LUMP_DEBUG_PRINTLN("[Info] LPF2 host detected");
+
+                    isLpf2Host  = true;
+                    deviceState = LumpDeviceState::InitUart;
+                  }
+                  break;
+                case LUMP_CMD_SELECT:
+                  if (deviceState == LumpDeviceState::Communicating) {
+                    deviceMode      = rxBuffer[1];
+                    deviceState     = LumpDeviceState::InitMode;
+                    numComboEntries = 0;
+
+                    LUMP_DEBUG_PRINT("| select mode: ");
+                    LUMP_DEBUG_PRINTLN(deviceMode);
+
+                    if (selectCallback) {
+                      selectCallback(deviceMode);
+                    }
+                  }
+                  break;
+                case LUMP_CMD_WRITE:
+                  if (deviceState == LumpDeviceState::Communicating) {
+                    if (numModeCombos > 0 && msgSize >= 2 && rxBuffer[1] == LUMP_CMD_WRITE_COMBI_SETUP) {
+                      /**
+                       * Selects a mode combination.
+                       * Payload: `LUMP_CMD_WRITE_COMBI_SETUP`, combination index, then one byte per value
+                       *          (mode in the high nibble, dataset in the low nibble), zero-padded to the message size.
+                       *
+                       * Padding looks like an entry for mode 0, dataset 0, so the number of entries is bounded by the
+                       * number of values the combination holds instead. Extra entries only append values after the
+                       * requested ones.
+                       */
+                      uint8_t num = min(static_cast<uint8_t>(msgSize - 2), comboCapacity(rxBuffer[2]));
+                      if (!num) {
+                        LUMP_DEBUG_PRINTLN("| combi setup: invalid");
+                        break;
+                      }
+
+                      comboIdx        = rxBuffer[2];
+                      numComboEntries = num;
+                      memcpy(comboEntries, &rxBuffer[3], num);
+                      _hasComboSelect = true;
+
+                      LUMP_DEBUG_PRINT("| combi setup: ");
+                      LUMP_DEBUG_PRINTLN(comboIdx);
+                      break;
+                    }
+
+                    if (writeCallback) {
+                      writeCallback(&rxBuffer[1], msgSize); // Zero-copy view, valid during the call.
+                    } else if (msgSize <= sizeof(cmdWriteData)) {
+                      queueCmdWrite(msgSize);
+#if LUMP_THREADED_RUNNER
+                      publishHostMsg(hostCmdWrites, deviceMode, msgSize);
+#endif
+                    }
 
-                  LUMP_DEBUG_PRINT("| cmd write data, size: ");
-                  LUMP_DEBUG_PRINT(msgSize);
-                  LUMP_DEBUG_PRINTLN((msgSize <= sizeof(cmdWriteData)) ? "" : ", invalid");
-                }
-                break;
-              case LUMP_CMD_EXT_MODE:
-                if (deviceState == LumpDeviceState::Communicating) {
-                  extMode = rxBuffer[1];
+                    LUMP_DEBUG_PRINT("| cmd write data, size: ");
+                    LUMP_DEBUG_PRINT(msgSize);
+                    LUMP_DEBUG_PRINTLN((msgSize <= sizeof(cmdWriteData)) ? "" : ", invalid");
+                  }
+                  break;
+                case LUMP_CMD_EXT_MODE:
+                  if (deviceState == LumpDeviceState::Communicating) {
+                    extMode = rxBuffer[1];
 
-                  LUMP_DEBUG_PRINT("| ext mode: ");
-                  LUMP_DEBUG_PRINTLN(extMode);
+                    LUMP_DEBUG_PRINT("| ext mode: ");
+                    LUMP_DEBUG_PRINTLN(extMode);
+                  }
+                  break;
+                default:
+                  LUMP_DEBUG_PRINTLN("| unknown");
+                  break;
+              }
+              break;
+            case LUMP_MSG_TYPE_DATA:
+              if (deviceState == LumpDeviceState::Communicating) {
+                uint8_t mode = msgCmd + extMode;
+
+                void *dataMsg = dataMsgBuffer(mode);
+
+                if (dataCallback && mode < numModes) {
+                  dataCallback(mode, &rxBuffer[1], msgSize); // Zero-copy view, valid during the call.
+                } else if (dataMsg && msgSize >= modes[mode].dataMsgSize) {
+                  memcpy(dataMsg, &rxBuffer[1], modes[mode].dataMsgSize);
+                  dataMsgFlags |= 1u << mode;
+#if LUMP_THREADED_RUNNER
+                  publishHostMsg(hostDataMsgs, mode, modes[mode].dataMsgSize);
+#endif
+                } else if (!dataMsg && mode < numModes && modes[mode].mapOut != LUMP_INFO_MAPPING_NONE) {
+                  ++rxDataDrops; // The mode did not fit in the data message arena.
                 }
-                break;
-              default:
-                LUMP_DEBUG_PRINTLN("| unknown");
-                break;
-            }
-            break;
-          case LUMP_MSG_TYPE_DATA:
-            if (deviceState == LumpDeviceState::Communicating) {
-              uint8_t mode = msgCmd + extMode;
 
-              if (mode < numModes && modes[mode].dataMsg && msgSize >= modes[mode].dataMsgSize) {
-                memcpy(modes[mode].dataMsg, &rxBuffer[1], modes[mode].dataMsgSize);
-                modes[mode].hasDataMsg = true;
+                LUMP_DEBUG_PRINT("| data msg, mode: ");
+                LUMP_DEBUG_PRINT(mode);
+                LUMP_DEBUG_PRINT(", size: ");
+                LUMP_DEBUG_PRINT(msgSize);
+                LUMP_DEBUG_PRINTLN(
+                    ((dataCallback && mode < numModes) || (dataMsg && msgSize >= modes[mode].dataMsgSize)) ? ""
+                                                                                                           : ", invalid"
+                );
               }
-
-              LUMP_DEBUG_PRINT("| data msg, mode: ");
-              LUMP_DEBUG_PRINT(mode);
-              LUMP_DEBUG_PRINT(", size: ");
-              LUMP_DEBUG_PRINT(msgSize);
-              LUMP_DEBUG_PRINTLN(
-                  (mode < numModes && modes[mode].dataMsg && msgSize >= modes[mode].dataMsgSize) ? "" : ", invalid"
-              );
-            }
-            break;
-          default:
-            LUMP_DEBUG_PRINTLN("| unknown");
-            break;
+              break;
+            default:
+              LUMP_DEBUG_PRINTLN("| unknown");
+              break;
+          }
+          receiverState = LumpReceiverState::ReadByte;
+          break;
         }
-        receiverState = LumpReceiverState::ReadByte;
-        break;
+        default:
+          break;
       }
-      default:
-        break;
     }
   }
 
@@ -701,9 +1041,90 @@ namespace LumpDeviceBuilder {
   template <typename T>
   void LumpDevice<T>::initUart(uint32_t speed) {
     uart->end();
-    pinMode(txPin, OUTPUT);
-    digitalWrite(txPin, HIGH);
+    LUMP_PIN_MODE(txPin, OUTPUT);
+    LUMP_DIGITAL_WRITE(txPin, HIGH);
     uart->begin(speed);
+
+    txCapacity   = Internal::availableForWrite(uart, 0); // The TX buffer is empty right after initialization.
+    txByteMicros = 10000000UL / speed;                   // 8N1: 10 bits per byte.
+
+    /* Discards the messages queued for the previous speed. */
+    txQueueHead  = 0;
+    txQueueLen   = 0;
+    txDataOffset = -1;
+
+    announcedExtMode = UINT8_MAX;
+
+#if LUMP_RX_RING_SIZE > 0
+    rxRing.clear(); // Bytes received at the previous speed are discarded, like `end()` does for the core buffer.
+#endif
+  }
+
+  template <typename T>
+  bool LumpDevice<T>::txWrite(uint8_t *msg, uint8_t len) {
+    if (!hasTxSpace(len)) {
+      return false;
+    }
+
+    pushTxQueue(msg, len);
+    drainTxQueue();
+    return true;
+  }
+
+  template <typename T>
+  bool LumpDevice<T>::hasTxSpace(uint8_t len) {
+    drainTxQueue();
+    return len <= sizeof(txQueue) - txQueueLen;
+  }
+
+  template <typename T>
+  void LumpDevice<T>::pushTxQueue(uint8_t *msg, uint8_t len) {
+    uint16_t tail = (txQueueHead + txQueueLen) % sizeof(txQueue);
+    uint16_t part = min(static_cast<uint16_t>(len), static_cast<uint16_t>(sizeof(txQueue) - tail));
+
+    memcpy(&txQueue[tail], msg, part);
+    memcpy(txQueue, &msg[part], len - part);
+    txQueueLen += len;
+    LUMP_LINK_STATS_ADD(txBytes, len);
+    traceFrame(LumpTraceEvent::TxFrame, msg, len);
+  }
+
+  template <typename T>
+  void LumpDevice<T>::drainTxQueue() {
+    if (txCapacity <= 0) {
+      /* The free space is unknown. Writes everything. */
+      flushTxQueue();
+      return;
+    }
+
+    int space = Internal::availableForWrite(uart, 0);
+    while (txQueueLen && space > 0) {
+      uint16_t part = min(txQueueLen, static_cast<uint16_t>(sizeof(txQueue) - txQueueHead));
+      part          = min(part, static_cast<uint16_t>(space));
+
+      uart->write(&txQueue[txQueueHead], part);
+      popTxQueue(part);
+      space -= part;
+    }
+  }
+
+  template <typename T>
+  void LumpDevice<T>::flushTxQueue() {
+    while (txQueueLen) {
+      uint16_t part = min(txQueueLen, static_cast<uint16_t>(sizeof(txQueue) - txQueueHead));
+
+      uart->write(&txQueue[txQueueHead], part);
+      popTxQueue(part);
+    }
+  }
+
+  template <typename T>
+  void LumpDevice<T>::popTxQueue(uint16_t len) {
+    txQueueHead = (txQueueHead + len) % sizeof(txQueue);
+    txQueueLen -= len;
+
+    /* A data message can no longer be coalesced once it has started to be written. */
+    txDataOffset = (txDataOffset >= static_cast<int16_t>(len)) ? txDataOffset - len : -1;
   }
 
   template <typename T>
@@ -717,11 +1138,159 @@ namespace LumpDeviceBuilder {
       memcpy(&txBuffer[6], &(valueSpan.max), 4);
       txBuffer[10] = calcChecksum(txBuffer, 10);
 
-      LUMP_DEBUG_PRINT_TX_BUFFER(txBuffer, 11);
-      uartWrite(txBuffer, 11);
+      writeHandshakeMsg(txBuffer, 11);
+    }
+  }
+
+  template <typename T>
+  bool LumpDevice<T>::writeHandshakeMsg(uint8_t *msg, uint8_t len) {
+    if (!txWrite(msg, len)) {
+      return false;
+    }
+
+    if (hsImageBuffer && !hsImageReady) {
+      if (hsImageLen + len <= hsImageSize) {
+        memcpy(&hsImageBuffer[hsImageLen], msg, len);
+        hsImageLen += len;
+      } else {
+        LUMP_DEBUG_PRINTLN("[Info] Handshake image overflow, disabled");
+        hsImageBuffer = nullptr;
+        hsImage       = nullptr;
+      }
+    }
+
+    return true;
+  }
+
+  template <typename T>
+  void LumpDevice<T>::selectHandshakeImage(uint8_t numMsgs) {
+    using namespace LumpDeviceBuilder::Internal;
+
+    hsImageEnd = hsImageIdx;
+
+    if (numMsgs) {
+      /* Selects the specified number of messages. */
+      while (numMsgs-- && hsImageEnd < hsImageLen) {
+        hsImageEnd += sizeOfMsg(hsImageAt(hsImageEnd));
+      }
+    } else {
+      /* Selects all messages of a mode, up to the name of the next mode. */
+      do {
+        hsImageEnd += sizeOfMsg(hsImageAt(hsImageEnd));
+      } while (hsImageEnd < hsImageLen && (hsImageAt(hsImageEnd + 1) & ~LUMP_INFO_MODE_PLUS_8) != LUMP_INFO_NAME);
+    }
+  }
+
+  template <typename T>
+  bool LumpDevice<T>::streamHandshakeImage() {
+    using namespace LumpDeviceBuilder::Internal;
+
+    drainTxQueue();
+
+    /**
+     * Queues as many whole messages of the selection as fit.
+     * A message is never split, so a NACK queued in between cannot land inside a message on the wire.
+     */
+    while (hsImageIdx < hsImageEnd) {
+      uint8_t len = sizeOfMsg(hsImageAt(hsImageIdx));
+      if (len > sizeof(txQueue) - txQueueLen) {
+        break;
+      }
+
+      for (uint8_t i = 0; i < len; i++) {
+        txBuffer[i] = hsImageAt(hsImageIdx + i); // The image may be in flash.
+      }
+      pushTxQueue(txBuffer, len);
+      hsImageIdx += len;
+    }
+    drainTxQueue();
+
+    return hsImageIdx == hsImageEnd;
+  }
+
+  template <typename T>
+  void LumpDevice<T>::setFlashHandshakeImage(const uint8_t *image, uint16_t len) {
+    using namespace LumpDeviceBuilder::Internal;
+
+    hsImageBuffer  = nullptr;
+    hsImage        = image;
+    hsImageInFlash = true;
+    hsImageSize    = len;
+    hsImageLen     = len;
+    hsImageIdx     = 0;
+    hsImageEnd     = 0;
+    hsImageSpeed   = 0;
+
+    /* Walks the messages: the type must match, and there must be a name per mode. */
+    uint16_t idx      = 0;
+    uint8_t msg       = 0;
+    uint8_t modeNames = 0;
+    bool typeMatches  = len > 1 && hsImageAt(1) == type;
+    while (idx + 1 < len) {
+      uint8_t header = hsImageAt(idx);
+      if (msg == 2 && idx + 4 < len) {
+        /* The third message is the speed, in little endian. */
+        for (uint8_t i = 4; i > 0; i--) {
+          hsImageSpeed = (hsImageSpeed << 8) | hsImageAt(idx + i);
+        }
+      }
+      if ((header & LUMP_MSG_TYPE_MASK) == LUMP_MSG_TYPE_INFO &&
+          (hsImageAt(idx + 1) & ~LUMP_INFO_MODE_PLUS_8) == LUMP_INFO_NAME) {
+        modeNames++;
+      }
+      idx += sizeOfMsg(header);
+      msg++;
+    }
+
+    if (!typeMatches || modeNames != numModes || idx != len) {
+      LUMP_DEBUG_PRINTLN("[Error] Handshake image does not match the device, ignored");
+      hsImage        = nullptr;
+      hsImageInFlash = false;
+      hsImageLen     = 0;
+      hsImageReady   = false;
+      return;
+    }
+
+    hsImageReady = true;
+  }
+
+#if LUMP_TRACE_SIZE > 0
+  template <typename T>
+  uint16_t LumpDevice<T>::readTrace(LumpTraceRecord *records, uint16_t maxRecords) {
+    if (traceHead - traceTail > LUMP_TRACE_SIZE) {
+      /* The oldest records have been overwritten. */
+      traceLost += traceHead - traceTail - LUMP_TRACE_SIZE;
+      traceTail = traceHead - LUMP_TRACE_SIZE;
+    }
+
+    uint16_t num = 0;
+    while (num < maxRecords && traceTail != traceHead) {
+      records[num++] = traceRing[traceTail++ & (LUMP_TRACE_SIZE - 1)];
     }
+    return num;
   }
 
+  template <typename T>
+  template <typename S>
+  void LumpDevice<T>::dumpTrace(S &out) {
+    uint32_t lost = traceLost;
+    uint16_t num  = min(traceHead - traceTail, static_cast<uint32_t>(LUMP_TRACE_SIZE));
+    if (traceHead - traceTail > LUMP_TRACE_SIZE) {
+      lost += traceHead - traceTail - LUMP_TRACE_SIZE;
+    }
+
+    uint8_t header[12] = {'L', 'T', 'R', 'C', 1, sizeof(LumpTraceRecord)};
+    memcpy(&header[6], &num, sizeof(num));
+    memcpy(&header[8], &lost, sizeof(lost));
+    out.write(header, sizeof(header));
+
+    LumpTraceRecord record;
+    while (readTrace(&record, 1)) {
+      out.write(reinterpret_cast<const uint8_t *>(&record), sizeof(record));
+    }
+  }
+#endif
+
   template <typename T>
   bool LumpDevice<T>::hasNack() {
     bool tmp = _hasNack;
@@ -729,33 +1298,83 @@ namespace LumpDeviceBuilder {
     return tmp;
   }
 
+  template <typename T>
+  bool LumpDevice<T>::hasComboSelect() {
+    bool tmp        = _hasComboSelect;
+    _hasComboSelect = false;
+    return tmp;
+  }
+
   template <typename T>
   void LumpDevice<T>::clearCmdWriteData() {
     cmdWriteDataSize = 0;
-    _hasCmdWriteData = false;
+    cmdWriteHead     = 0;
+    cmdWriteLen      = 0;
     memset(cmdWriteData, 0, sizeof(cmdWriteData));
   }
 
   template <typename T>
   bool LumpDevice<T>::hasCmdWriteData() {
-    bool tmp         = _hasCmdWriteData;
-    _hasCmdWriteData = false;
-    return tmp;
+    if (!cmdWriteLen) {
+      return false;
+    }
+
+    const CmdWrite &entry = cmdWrites[cmdWriteHead];
+    cmdWriteDataSize      = entry.size;
+    cmdWriteDataMillis    = entry.millis;
+    memcpy(cmdWriteData, entry.data, entry.size);
+    memset(&cmdWriteData[entry.size], 0, sizeof(cmdWriteData) - entry.size);
+
+    cmdWriteHead = (cmdWriteHead + 1) % LUMP_CMD_WRITE_QUEUE_SIZE;
+    --cmdWriteLen;
+    return true;
+  }
+
+  template <typename T>
+  void LumpDevice<T>::queueCmdWrite(uint8_t size) {
+    uint8_t idx;
+
+    if (cmdWriteLen < LUMP_CMD_WRITE_QUEUE_SIZE) {
+      idx = (cmdWriteHead + cmdWriteLen) % LUMP_CMD_WRITE_QUEUE_SIZE;
+      ++cmdWriteLen;
+    } else {
+      ++cmdWriteDrops;
+
+      switch (cmdWritePolicy) {
+        case LumpOverflowPolicy::DropNewest:
+          return;
+        case LumpOverflowPolicy::Coalesce:
+          idx = (cmdWriteHead + cmdWriteLen - 1) % LUMP_CMD_WRITE_QUEUE_SIZE;
+          break;
+        case LumpOverflowPolicy::DropOldest:
+        default:
+          idx          = cmdWriteHead;
+          cmdWriteHead = (cmdWriteHead + 1) % LUMP_CMD_WRITE_QUEUE_SIZE;
+          break;
+      }
+    }
+
+    CmdWrite &entry = cmdWrites[idx];
+    entry.size      = size;
+    entry.millis    = currentMillis;
+    memcpy(entry.data, &rxBuffer[1], size);
   }
 
   template <typename T>
   void LumpDevice<T>::clearDataMsg(uint8_t mode) {
-    if (modes[mode].dataMsg) {
-      modes[mode].hasDataMsg = false;
-      memset(modes[mode].dataMsg, 0, modes[mode].dataMsgSize);
+    void *dataMsg = dataMsgBuffer(mode);
+
+    if (dataMsg) {
+      dataMsgFlags &= ~(1u << mode);
+      memset(dataMsg, 0, modes[mode].dataMsgSize);
     }
   }
 
   template <typename T>
   bool LumpDevice<T>::hasDataMsg(uint8_t mode) {
     if (mode < numModes) {
-      bool tmp               = modes[mode].hasDataMsg;
-      modes[mode].hasDataMsg = false;
+      bool tmp = dataMsgFlags & (1u << mode);
+      dataMsgFlags &= ~(1u << mode);
       return tmp;
     }
     return false;
@@ -764,32 +1383,344 @@ namespace LumpDeviceBuilder {
   template <typename T>
   template <typename U>
   U *LumpDevice<T>::readDataMsg(uint8_t mode) {
-    if (mode < numModes && modes[mode].dataMsg) {
-      return reinterpret_cast<U *>(modes[mode].dataMsg);
+    void *dataMsg = dataMsgBuffer(mode);
+
+    if (dataMsg) {
+      return reinterpret_cast<U *>(dataMsg);
     }
     return nullptr;
   }
 
+  template <typename T>
+  void LumpDevice<T>::sendCombo(const void *const *data) {
+    uint8_t *payload = &dataTxBuffer[LUMP_DATA_TX_OFFSET + 1];
+    uint8_t len      = 0;
+
+    for (uint8_t i = 0; i < numComboEntries; ++i) {
+      uint8_t mode    = comboEntries[i] >> 4;
+      uint8_t dataset = comboEntries[i] & 0x0f;
+
+      if (mode >= numModes || !data[mode] || dataset >= modes[mode].numData) {
+        continue;
+      }
+
+      uint8_t size = modes[mode].dataTypeSize;
+      if (len + size > LUMP_MAX_MSG_SIZE) {
+        break;
+      }
+
+      memcpy(&payload[len], static_cast<const uint8_t *>(data[mode]) + dataset * size, size);
+      len += size;
+    }
+
+    if (len) {
+      commitDataMsg(len, deviceMode);
+    }
+  }
+
+  template <typename T>
+  uint8_t LumpDevice<T>::comboCapacity(uint8_t combo) {
+    if (combo >= numModeCombos) {
+      return 0;
+    }
+
+    uint8_t num = 0;
+    for (uint8_t i = 0; i < numModes; ++i) {
+      if (modeCombos[combo] & (1u << i)) {
+        num += modes[i].numData;
+      }
+    }
+    return num;
+  }
+
+  template <typename T>
+  template <typename U>
+  U *LumpDevice<T>::reserve(uint8_t mode) {
+    if (mode >= numModes) {
+      return nullptr;
+    }
+
+    reservedMode = mode;
+    return reinterpret_cast<U *>(&dataTxBuffer[LUMP_DATA_TX_OFFSET + 1]);
+  }
+
+  template <typename T>
+  void LumpDevice<T>::commit() {
+    if (reservedMode < numModes) {
+      commitDataMsg(modes[reservedMode].dataMsgSize, reservedMode);
+      reservedMode = UINT8_MAX;
+    }
+  }
+
   template <typename T>
   void LumpDevice<T>::sendDataMsg(void *payload, uint8_t len, uint8_t mode) {
+    memcpy(&dataTxBuffer[LUMP_DATA_TX_OFFSET + 1], payload, len);
+    commitDataMsg(len, mode);
+  }
+
+  template <typename T>
+  void LumpDevice<T>::commitDataMsg(uint8_t len, uint8_t mode) {
+    using namespace LumpDeviceBuilder::Internal;
+
+    uint8_t *msg    = &dataTxBuffer[LUMP_DATA_TX_OFFSET];
+    uint8_t msgSize = queryNextPow2(len);
+    uint8_t msgLen  = msgSize + 2;
+    msg[0]          = encMsgHeader(LUMP_MSG_TYPE_DATA, msgSize, mode % (LUMP_MAX_MODE + 1));
+    memset(&msg[len + 1], 0, msgSize - len); // Zero-pads the payload to the message size.
+    msg[msgSize + 1] = calcChecksum(msg, msgSize + 1);
+
+    queueDataMsg(msgLen, mode);
+  }
+
+  template <typename T>
+  void LumpDevice<T>::runSchedule() {
+    using namespace LumpDeviceBuilder::Internal;
+
+    if (deviceMode >= numSchedules || !schedules[deviceMode].sampler || numComboEntries || reservedMode != UINT8_MAX) {
+      return;
+    }
+
+    const LumpModeSchedule &schedule = schedules[deviceMode];
+    const LumpMode &mode             = modes[deviceMode];
+
+    if (_hasNack) {
+      /* The host has not received data for a while. Resends immediately. */
+      _hasNack   = false;
+      schedForce = true;
+    } else if (static_cast<int32_t>(currentMicros - schedMicros) < 0) {
+      return;
+    } else if (txDataOffset >= 0 && txDataMode == deviceMode) {
+      /* The previous data message is still queued. Postpones the sample until the link catches up. */
+      return;
+    }
+
+    uint8_t *payload = &dataTxBuffer[LUMP_DATA_TX_OFFSET + 1];
+    memset(payload, 0, mode.dataMsgSize);
+
+    if (schedule.sampler(deviceMode, payload)) {
+      if (schedForce || schedule.policy == LumpSendPolicy::Periodic ||
+          exceedsDeadband(payload, schedPayload, mode.dataType, mode.numData, schedule.deadband)) {
+        memcpy(schedPayload, payload, mode.dataMsgSize);
+        commitDataMsg(mode.dataMsgSize, deviceMode);
+        schedForce = false;
+      }
+    }
+
+    /* Keeps a steady rate. Resynchronizes if more than one period behind, or after an unscheduled resend. */
+    schedMicros += schedule.period;
+    if (static_cast<int32_t>(currentMicros - schedMicros) >= 0 || schedMicros - currentMicros > schedule.period) {
+      schedMicros = currentMicros + schedule.period;
+    }
+  }
+
+  template <typename T>
+  void LumpDevice<T>::recordLinkError(bool isNack) {
+    if (!adaptiveSpeed) {
+      return;
+    }
+
+    if (currentMillis - linkWindowMillis > LUMP_SPEED_ERROR_WINDOW) {
+      linkWindowMillis = currentMillis;
+      linkErrors       = 0;
+      linkNacks        = 0;
+    }
+
+    if (!isNack) {
+      linkErrorMillis = currentMillis;
+    }
+
+    bool exceeded = isNack ? (++linkNacks > LUMP_SPEED_NACK_LIMIT) : (++linkErrors >= LUMP_SPEED_ERROR_LIMIT);
+    if (exceeded && lowerSpeed()) {
+      LUMP_DEBUG_PRINTLN("[Info] Soft reset...");
+      deviceState = LumpDeviceState::Reset;
+    }
+  }
+
+  template <typename T>
+  bool LumpDevice<T>::lowerSpeed() {
+    uint32_t lower = Internal::lowerUartSpeed(speed);
+
+    if (!adaptiveSpeed || lower == speed) {
+      return false;
+    }
+
+    LUMP_DEBUG_PRINT("[Info] Lowering speed to: ");
+    LUMP_DEBUG_PRINTLN(lower);
+
+    speed        = lower;
+    hsImageReady = false; // The image contains the speed.
+    ++speedDowngrades;
+    return true;
+  }
+
+  template <typename T>
+  template <typename F, typename U>
+  void LumpDevice<T>::_sendAs(const U *data, uint8_t mode) {
+    using namespace LumpDeviceBuilder::Internal;
+
+    static_assert(isLumpDataType<U, F::dataType>::value, "Data type does not match the data format");
+
+#ifdef LUMP_DEBUG_SERIAL
+    if (mode < numModes && (modes[mode].dataType != F::dataType || modes[mode].numData != F::numData)) {
+      LUMP_DEBUG_PRINT("[Error] Data format does not match mode: ");
+      LUMP_DEBUG_PRINTLN(mode);
+      return;
+    }
+#endif
+
+    uint8_t *msg = &dataTxBuffer[LUMP_DATA_TX_OFFSET];
+    msg[0]       = F::msgHeader | (mode % (LUMP_MAX_MODE + 1));
+    memcpy(&msg[1], data, F::payloadSize);
+    memset(&msg[F::payloadSize + 1], 0, F::msgSize - F::payloadSize); // Zero-pads the payload to the message size.
+    msg[F::msgSize + 1] = calcChecksum(msg, F::msgSize + 1);
+
+    queueDataMsg(F::msgSize + 2, mode);
+  }
+
+  template <typename T>
+  void LumpDevice<T>::queueDataMsg(uint8_t msgLen, uint8_t mode) {
     using namespace LumpDeviceBuilder::Internal;
 
+    uint8_t *msg = &dataTxBuffer[LUMP_DATA_TX_OFFSET];
+
+    drainTxQueue();
+
+    if (txDataOffset >= 0 && txDataMode == mode && txDataLen == msgLen) {
+      /* A data message for the same mode is still queued. Replaces it with the new one, which is not traced again. */
+      uint16_t idx  = (txQueueHead + txDataOffset) % sizeof(txQueue);
+      uint16_t part = min(static_cast<uint16_t>(msgLen), static_cast<uint16_t>(sizeof(txQueue) - idx));
+
+      memcpy(&txQueue[idx], msg, part);
+      memcpy(txQueue, &msg[part], msgLen - part);
+      ++txCoalesces;
+      return;
+    }
+
+    /* Announces the extended mode only if the host may not know it yet. */
+    uint8_t extModeLen = 0;
+    uint8_t newExtMode = (mode > LUMP_MAX_MODE) ? LUMP_EXT_MODE_8 : LUMP_EXT_MODE_0;
     if (numModes > LUMP_MAX_MODE + 1) {
-      txBuffer[0] = encMsgHeader(LUMP_MSG_TYPE_CMD, 1, LUMP_CMD_EXT_MODE);
-      txBuffer[1] = (mode > LUMP_MAX_MODE) ? LUMP_EXT_MODE_8 : LUMP_EXT_MODE_0;
-      txBuffer[2] = calcChecksum(txBuffer, 2);
+      if (newExtMode != announcedExtMode || currentMillis - extModeMillis >= extModeRefreshInterval) {
+        extModeLen = 3;
+      }
+    }
 
-      LUMP_DEBUG_PRINT_TX_BUFFER(txBuffer, 3);
-      uartWrite(txBuffer, 3);
+    if (extModeLen + msgLen > sizeof(txQueue) - txQueueLen) {
+      /* The link is saturated. Drops the new data message instead of blocking. */
+      ++txDrops;
+      trace(LumpTraceEvent::TxDrop, mode, nullptr, 0);
+      LUMP_DEBUG_PRINT("[Warn] TX queue full, data message dropped, mode: ");
+      LUMP_DEBUG_PRINTLN(mode);
+      return;
     }
 
-    uint8_t msgSize = queryNextPow2(len);
-    txBuffer[0]     = encMsgHeader(LUMP_MSG_TYPE_DATA, msgSize, mode % (LUMP_MAX_MODE + 1));
-    memcpy(&txBuffer[1], payload, len);
-    txBuffer[msgSize + 1] = calcChecksum(txBuffer, msgSize + 1);
+    if (extModeLen) {
+      uint8_t extModeMsg[3];
+      extModeMsg[0] = encMsgHeader(LUMP_MSG_TYPE_CMD, 1, LUMP_CMD_EXT_MODE);
+      extModeMsg[1] = newExtMode;
+      extModeMsg[2] = calcChecksum(extModeMsg, 2);
+
+      pushTxQueue(extModeMsg, 3);
+
+      announcedExtMode = newExtMode;
+      extModeMillis    = currentMillis;
+    } else if (numModes > LUMP_MAX_MODE + 1) {
+      extModeSaved += 3;
+    }
+
+    txDataOffset = txQueueLen;
+    txDataMode   = mode;
+    txDataLen    = msgLen;
+    pushTxQueue(msg, msgLen);
+    LUMP_LINK_STATS_INC(txDataMsgs);
+    drainTxQueue();
+  }
+
+  template <uint8_t N>
+  template <typename T>
+  bool LumpHub<N>::add(LumpDevice<T> &device) {
+    if (numPorts >= N) {
+      return false;
+    }
+
+    devices[numPorts] = &device;
+    ops[numPorts]     = &PortOpsOf<T>::ops;
+    ++numPorts;
+    return true;
+  }
+
+  template <uint8_t N>
+  void LumpHub<N>::begin() {
+    for (uint8_t i = 0; i < numPorts; ++i) {
+      ops[i]->begin(devices[i]);
+    }
+  }
 
-    LUMP_DEBUG_PRINT_TX_BUFFER(txBuffer, msgSize + 2);
-    uartWrite(txBuffer, msgSize + 2);
+  template <uint8_t N>
+  void LumpHub<N>::end() {
+    for (uint8_t i = 0; i < numPorts; ++i) {
+      ops[i]->end(devices[i]);
+    }
+  }
+
+  template <uint8_t N>
+  void LumpHub<N>::run() {
+    if (!numPorts) {
+      return;
+    }
+
+    for (uint8_t n = 0, i = firstPort; n < numPorts; ++n, i = (i + 1) % numPorts) {
+      /* The rotation moves each device within the call, so the gaps are measured per device. */
+      uint32_t nowMicros = LUMP_MICROS();
+      if (serviced[i]) {
+        maxGap = max(maxGap, nowMicros - lastServiced[i]);
+      }
+      lastServiced[i] = nowMicros;
+      serviced[i]     = true;
+
+      ops[i]->run(devices[i]);
+    }
+    firstPort = (firstPort + 1) % numPorts;
+  }
+
+  template <uint8_t N>
+  uint32_t LumpHub<N>::timeToNextDeadline() {
+    uint32_t timeout = UINT32_MAX;
+
+    for (uint8_t i = 0; i < numPorts && timeout; ++i) {
+      timeout = min(timeout, ops[i]->timeToNextDeadline(devices[i]));
+    }
+    return timeout;
+  }
+
+  template <uint8_t N>
+  void LumpHub<N>::sleep() {
+    if (!sleepCallback) {
+      return;
+    }
+
+    for (uint8_t i = 0; i < numPorts; ++i) {
+      if (ops[i]->rxAvailable(devices[i])) {
+        return;
+      }
+    }
+
+    uint32_t timeout = timeToNextDeadline();
+    if (timeout && timeout != UINT32_MAX) {
+      sleepCallback(timeout);
+    }
+  }
+
+  template <uint8_t N>
+  void LumpHub<N>::setRxBudget(uint16_t budget) {
+    if (!numPorts) {
+      return;
+    }
+
+    uint16_t share = max(static_cast<uint16_t>(budget / numPorts), static_cast<uint16_t>(1));
+    for (uint8_t i = 0; i < numPorts; ++i) {
+      ops[i]->setRxBurstSize(devices[i], min(share, static_cast<uint16_t>(UINT8_MAX)));
+    }
   }
 
 } // namespace LumpDeviceBuilder
@@ -0,0 +1,453 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/**
+ * Capture and replay of UART sessions for LUMP Device Builder Library
+ *
+ * `LumpCaptureSerial` wraps the serial interface of a `LumpDevice` and records the received and sent bytes of a
+ * session with their timestamps. `LumpReplaySerial` feeds a capture back into a `LumpDevice` under simulated time
+ * (e.g., in a `LUMP_HOST_BUILD`) and compares the sent bytes with the captured ones.
+ *
+ * Capture format (little-endian):
+ * - Header: the `"LCAP"` magic, a version byte (`1`) and the start time (`uint32_t`, microseconds).
+ * - Records: the time since the previous record (unsigned LEB128, microseconds), a tag byte and a payload.
+ *   The two high bits of the tag select the record type (`LumpCaptureRecord`):
+ *   - `Rx`/`Tx`: the six low bits hold the number of payload bytes (1 to 63).
+ *   - `Begin`: the payload is the speed (`uint32_t`).
+ *   - `End`: no payload.
+ */
+
+#ifndef LUMP_DEVICE_BUILDER_CAPTURE_H
+#define LUMP_DEVICE_BUILDER_CAPTURE_H
+
+#include "LumpDeviceBuilder.h"
+
+#define LUMP_CAPTURE_VERSION     1
+#define LUMP_CAPTURE_HEADER_SIZE 9
+#define LUMP_CAPTURE_TYPE_MASK   0xc0
+#define LUMP_CAPTURE_LEN_MASK    0x3f
+
+namespace LumpDeviceBuilder {
+
+  /* Represents the type of a capture record. */
+  enum class LumpCaptureRecord : uint8_t {
+    Rx    = 0x00, // Bytes read from the serial interface.
+    Tx    = 0x40, // Bytes written to the serial interface.
+    Begin = 0x80, // Serial interface started.
+    End   = 0xc0, // Serial interface stopped.
+  };
+
+  /**
+   * Serial interface wrapper that captures a session.
+   *
+   * Consecutive bytes in the same direction are coalesced into one record while they are less than
+   * `LUMP_CAPTURE_COALESCE_MICROS` apart. Records are written to the output when complete, so the output should be
+   * fast enough not to disturb the protocol timing (e.g., a RAM buffer or a second UART at a higher speed).
+   *
+   * @tparam T Type of the serial interface (typically `hardwareSerial`).
+   * @tparam O Type of the output. Must provide `write(const uint8_t *buffer, size_t size)`.
+   */
+  template <typename T, typename O>
+  class LumpCaptureSerial {
+    public:
+      /**
+       * Constructs a capture wrapper.
+       *
+       * @param serial Pointer to the serial interface.
+       * @param out Pointer to the output.
+       */
+      LumpCaptureSerial(T *serial, O *out) : serial{serial}, out{out} {}
+
+      /* Serial interface */
+      inline void begin(uint32_t speed) {
+        serial->begin(speed);
+
+        uint8_t payload[4];
+        memcpy(payload, &speed, sizeof(speed));
+        writeRecord(LumpCaptureRecord::Begin, LUMP_MICROS(), payload, sizeof(payload));
+      }
+
+      inline void end() {
+        serial->end();
+        writeRecord(LumpCaptureRecord::End, LUMP_MICROS(), nullptr, 0);
+      }
+
+      inline int available() { return serial->available(); }
+
+      inline int read() {
+        int c = serial->read();
+        if (c >= 0) {
+          uint8_t byte = c;
+          capture(LumpCaptureRecord::Rx, &byte, 1);
+        }
+        return c;
+      }
+
+      inline size_t write(uint8_t c) {
+        capture(LumpCaptureRecord::Tx, &c, 1);
+        return serial->write(c);
+      }
+
+      inline size_t write(const uint8_t *buffer, size_t size) {
+        capture(LumpCaptureRecord::Tx, buffer, size);
+        return serial->write(buffer, size);
+      }
+
+      inline int availableForWrite() { return Internal::availableForWrite(serial, 0); }
+
+      inline void flush() { serial->flush(); }
+
+      /**
+       * Writes the pending record to the output.
+       *
+       * Call this before reading the output (e.g., at the end of a session).
+       */
+      inline void flushCapture() { writeChunk(); }
+
+      /**
+       * Gets the number of bytes written to the output.
+       *
+       * @return Number of bytes.
+       */
+      inline uint32_t capturedBytes() { return outBytes; }
+
+    private:
+      /**
+       * Appends RX or TX bytes to the pending record.
+       *
+       * @param type `LumpCaptureRecord::Rx` or `LumpCaptureRecord::Tx`.
+       * @param data Bytes.
+       * @param size Number of bytes.
+       */
+      void capture(LumpCaptureRecord type, const uint8_t *data, size_t size) {
+        uint32_t now = LUMP_MICROS();
+
+        while (size--) {
+          if (chunkLen &&
+              (type != chunkType || chunkLen == sizeof(chunk) || now - chunkMicros >= LUMP_CAPTURE_COALESCE_MICROS)) {
+            writeChunk();
+          }
+          if (!chunkLen) {
+            chunkType   = type;
+            chunkMicros = now;
+          }
+          chunk[chunkLen++] = *data++;
+        }
+      }
+
+      /* Writes the pending record to the output. */
+      void writeChunk() {
+        if (chunkLen) {
+          uint8_t len = chunkLen;
+          chunkLen    = 0;
+          writeRecord(chunkType, chunkMicros, chunk, len);
+        }
+      }
+
+      /**
+       * Writes a record to the output.
+       *
+       * @param type Record type.
+       * @param micros Timestamp.
+       * @param payload Payload.
+       * @param size Size of the payload.
+       */
+      void writeRecord(LumpCaptureRecord type, uint32_t micros, const uint8_t *payload, uint8_t size) {
+        if (type == LumpCaptureRecord::Begin || type == LumpCaptureRecord::End) {
+          writeChunk(); // Keeps the records in order.
+        }
+
+        if (!started) {
+          uint8_t header[LUMP_CAPTURE_HEADER_SIZE] = {'L', 'C', 'A', 'P', LUMP_CAPTURE_VERSION};
+          memcpy(&header[5], &micros, sizeof(micros));
+          output(header, sizeof(header));
+
+          prevMicros = micros;
+          started    = true;
+        }
+
+        /* Time since the previous record (LEB128) and tag. */
+        uint8_t record[6];
+        uint8_t len   = 0;
+        uint32_t time = micros - prevMicros;
+        do {
+          record[len++] = (time & 0x7f) | (time > 0x7f ? 0x80 : 0);
+          time >>= 7;
+        } while (time);
+        bool hasLen   = (type == LumpCaptureRecord::Rx || type == LumpCaptureRecord::Tx);
+        record[len++] = static_cast<uint8_t>(type) | (hasLen ? size : 0);
+
+        output(record, len);
+        output(payload, size);
+        prevMicros = micros;
+      }
+
+      inline void output(const uint8_t *data, uint8_t size) {
+        if (size) {
+          out->write(data, size);
+          outBytes += size;
+        }
+      }
+
+      T *serial;
+      O *out;
+
+      /* Pending record */
+      uint8_t chunk[LUMP_CAPTURE_LEN_MASK];
+      uint8_t chunkLen{0};
+      LumpCaptureRecord chunkType{LumpCaptureRecord::Rx};
+      uint32_t chunkMicros{0};
+
+      /* Output */
+      bool started{false};
+      uint32_t prevMicros{0};
+      uint32_t outBytes{0};
+  };
+
+  /**
+   * Serial interface that replays a captured session.
+   *
+   * Captured RX bytes become available once the (simulated) time since `rewind()` reaches their capture time.
+   * Written bytes are compared with the captured TX bytes in order.
+   *
+   * Example (host build, advancing a simulated clock):
+   * ```
+   * LumpReplaySerial replay(capture, size);
+   * LumpDevice<LumpReplaySerial> device(&replay, 0, 1, 68, 115200, modes, numModes);
+   * device.begin();
+   * while (!replay.done()) {
+   *   simulatedMicros += 100;
+   *   device.run();
+   * }
+   * // Compare replay.txMismatchCount(), replay.firstTxMismatch() and replay.txByteCount().
+   * ```
+   */
+  class LumpReplaySerial {
+    public:
+      /**
+       * Constructs a replay serial interface.
+       *
+       * @param capture Capture, as written by `LumpCaptureSerial`.
+       * @param size Size of the capture.
+       * @param txCapacity Value returned by `availableForWrite()`.
+       */
+      LumpReplaySerial(const uint8_t *capture, uint32_t size, int txCapacity = 64)
+          : capture{capture}, size{size}, txCapacity{txCapacity} {
+        rewind();
+      }
+
+      /**
+       * Restarts the replay at the current time.
+       */
+      void rewind() {
+        valid = size >= LUMP_CAPTURE_HEADER_SIZE && !memcmp(capture, "LCAP", 4) && capture[4] == LUMP_CAPTURE_VERSION;
+
+        rxCursor        = Cursor{};
+        txCursor        = Cursor{};
+        beginCursor     = Cursor{};
+        startMicros     = LUMP_MICROS();
+        txBytes         = 0;
+        txMismatches    = 0;
+        txExtra         = 0;
+        firstMismatch   = UINT32_MAX;
+        speedMismatches = 0;
+      }
+
+      /* Serial interface */
+      inline void begin(uint32_t speed) {
+        if (next(beginCursor, LumpCaptureRecord::Begin)) {
+          uint32_t captured;
+          memcpy(&captured, &capture[beginCursor.data], sizeof(captured));
+          beginCursor.idx = beginCursor.len; // Consumes the whole record.
+          speedMismatches += (captured != speed);
+        }
+      }
+
+      inline void end() {}
+
+      inline int available() {
+        if (!next(rxCursor, LumpCaptureRecord::Rx) || rxCursor.micros > LUMP_MICROS() - startMicros) {
+          return 0;
+        }
+        return rxCursor.len - rxCursor.idx;
+      }
+
+      inline int read() { return available() ? capture[rxCursor.data + rxCursor.idx++] : -1; }
+
+      inline size_t write(uint8_t c) {
+        if (next(txCursor, LumpCaptureRecord::Tx)) {
+          if (capture[txCursor.data + txCursor.idx++] != c) {
+            if (!txMismatches++) {
+              firstMismatch = txBytes;
+            }
+          }
+        } else {
+          ++txExtra;
+        }
+        ++txBytes;
+        return 1;
+      }
+
+      inline size_t write(const uint8_t *buffer, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+          write(buffer[i]);
+        }
+        return size;
+      }
+
+      inline int availableForWrite() { return txCapacity; }
+
+      inline void flush() {}
+
+      /**
+       * Checks whether all captured RX bytes have been read.
+       *
+       * @retval true The replay is complete (or the capture is invalid).
+       * @retval false Otherwise.
+       */
+      inline bool done() { return !next(rxCursor, LumpCaptureRecord::Rx); }
+
+      /**
+       * Gets the time at which the next captured RX bytes become available.
+       *
+       * Lets a simulation skip idle time.
+       *
+       * @return Timestamp (`LUMP_MICROS()`), or the current time if the replay is complete.
+       */
+      inline uint32_t nextRxMicros() {
+        return next(rxCursor, LumpCaptureRecord::Rx) ? startMicros + rxCursor.micros : LUMP_MICROS();
+      }
+
+      /**
+       * Checks whether the capture has a valid header.
+       *
+       * @retval true The capture is valid.
+       * @retval false Otherwise.
+       */
+      inline bool isValid() { return valid; }
+
+      /**
+       * Gets the number of bytes written.
+       *
+       * @return Number of bytes.
+       */
+      inline uint32_t txByteCount() { return txBytes; }
+
+      /**
+       * Gets the number of written bytes that differ from the captured TX bytes.
+       *
+       * @return Number of bytes.
+       */
+      inline uint32_t txMismatchCount() { return txMismatches; }
+
+      /**
+       * Gets the offset of the first written byte that differs from the captured TX bytes.
+       *
+       * @return Offset, or `UINT32_MAX` if none.
+       */
+      inline uint32_t firstTxMismatch() { return firstMismatch; }
+
+      /**
+       * Gets the number of bytes written beyond the end of the captured TX bytes.
+       *
+       * @return Number of bytes.
+       */
+      inline uint32_t txExtraCount() { return txExtra; }
+
+      /**
+       * Gets the number of `begin()` calls whose speed differs from the capture.
+       *
+       * @return Number of calls.
+       */
+      inline uint32_t speedMismatchCount() { return speedMismatches; }
+
+    private:
+      /* Position in the capture. */
+      struct Cursor {
+          uint32_t pos{LUMP_CAPTURE_HEADER_SIZE}; // Offset of the next record.
+          uint32_t micros{0};                     // Time of the current record since the start of the capture.
+          uint32_t data{0};                       // Offset of the payload of the current record.
+          uint8_t len{0};                         // Size of the payload of the current record.
+          uint8_t idx{0};                         // Number of payload bytes consumed.
+      };
+
+      /**
+       * Moves a cursor to a record of the given type with unconsumed payload bytes.
+       *
+       * @param cursor Cursor.
+       * @param type Record type.
+       * @retval true Found.
+       * @retval false The capture has no more records of this type.
+       */
+      bool next(Cursor &cursor, LumpCaptureRecord type) {
+        if (!valid) {
+          return false;
+        }
+
+        while (cursor.idx >= cursor.len) {
+          /* Time since the previous record (LEB128). */
+          uint32_t time = 0;
+          uint8_t shift = 0;
+          uint8_t byte;
+          do {
+            if (cursor.pos >= size || shift > 28) {
+              return false;
+            }
+            byte = capture[cursor.pos++];
+            time |= static_cast<uint32_t>(byte & 0x7f) << shift;
+            shift += 7;
+          } while (byte & 0x80);
+
+          if (cursor.pos >= size) {
+            return false;
+          }
+          uint8_t tag = capture[cursor.pos++];
+          uint8_t len;
+          switch (static_cast<LumpCaptureRecord>(tag & LUMP_CAPTURE_TYPE_MASK)) {
+            case LumpCaptureRecord::Begin:
+              len = 4;
+              break;
+            case LumpCaptureRecord::End:
+              len = 0;
+              break;
+            default:
+              len = tag & LUMP_CAPTURE_LEN_MASK;
+              break;
+          }
+          if (cursor.pos + len > size) {
+            return false;
+          }
+
+          cursor.micros += time;
+          cursor.data = cursor.pos;
+          cursor.pos += len;
+          if ((tag & LUMP_CAPTURE_TYPE_MASK) == static_cast<uint8_t>(type)) {
+            cursor.len = len;
+            cursor.idx = 0;
+          }
+        }
+        return true;
+      }
+
+      const uint8_t *capture;
+      uint32_t size;
+      int txCapacity;
+      bool valid{false};
+
+      Cursor rxCursor;
+      Cursor txCursor;
+      Cursor beginCursor;
+      uint32_t startMicros{0};
+
+      /* Comparison */
+      uint32_t txBytes{0};
+      uint32_t txMismatches{0};
+      uint32_t txExtra{0};
+      uint32_t firstMismatch{UINT32_MAX};
+      uint32_t speedMismatches{0};
+  };
+
+} // namespace LumpDeviceBuilder
+
+#endif // LUMP_DEVICE_BUILDER_CAPTURE_H
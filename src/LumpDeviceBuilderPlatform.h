@@ -0,0 +1,95 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * Platform settings for LUMP Device Builder Library
+ *
+ * This header file maps the time and pin functions used by the LUMP Device Builder Library.
+ *
+ * By default, the Arduino core functions are used.
+ * Defining `LUMP_HOST_BUILD` before including the library header builds the library without the Arduino core
+ * (e.g., on a Linux host for simulations). In this case:
+ * - `LUMP_MILLIS()` and `LUMP_MICROS()` must be defined to provide a (virtual) clock in milliseconds and microseconds.
+ * - The pin functions are stubbed unless `LUMP_PIN_MODE` and `LUMP_DIGITAL_WRITE` are defined.
+ * - `LUMP_TASK_YIELD()` does nothing unless defined.
+ *
+ * `LUMP_PROGMEM` places constant data in flash on AVR, where it must be read with `LUMP_READ_PROGMEM_BYTE()`.
+ * Other MCUs read flash directly.
+ */
+
+#ifndef LUMP_DEVICE_BUILDER_PLATFORM_H
+#define LUMP_DEVICE_BUILDER_PLATFORM_H
+
+#ifdef LUMP_HOST_BUILD
+  #include <algorithm>
+  #include <ctype.h>
+  #include <math.h>
+  #include <stddef.h>
+  #include <stdint.h>
+  #include <stdlib.h>
+  #include <string.h>
+
+using std::max;
+using std::min;
+
+  #ifndef LOW
+    #define LOW 0x0
+  #endif
+  #ifndef HIGH
+    #define HIGH 0x1
+  #endif
+  #ifndef OUTPUT
+    #define OUTPUT 0x1
+  #endif
+
+  #ifndef LUMP_MILLIS
+    #error "LUMP_MILLIS() must be defined when LUMP_HOST_BUILD is defined"
+  #endif
+  #ifndef LUMP_MICROS
+    #error "LUMP_MICROS() must be defined when LUMP_HOST_BUILD is defined"
+  #endif
+  #ifndef LUMP_PIN_MODE
+    #define LUMP_PIN_MODE(pin, mode) ((void)0)
+  #endif
+  #ifndef LUMP_DIGITAL_WRITE
+    #define LUMP_DIGITAL_WRITE(pin, value) ((void)0)
+  #endif
+  #ifndef LUMP_TASK_YIELD
+    #define LUMP_TASK_YIELD() ((void)0)
+  #endif
+#else
+  #include <Arduino.h>
+#endif
+
+#ifndef LUMP_MILLIS
+  #define LUMP_MILLIS() millis()
+#endif
+#ifndef LUMP_MICROS
+  #define LUMP_MICROS() micros()
+#endif
+#ifndef LUMP_PIN_MODE
+  #define LUMP_PIN_MODE(pin, mode) pinMode(pin, mode)
+#endif
+#ifndef LUMP_DIGITAL_WRITE
+  #define LUMP_DIGITAL_WRITE(pin, value) digitalWrite(pin, value)
+#endif
+#ifndef LUMP_TASK_YIELD
+  #ifdef ESP32
+    #define LUMP_TASK_YIELD() vTaskDelay(1) // Lets the idle task run, which feeds the task watchdog.
+  #else
+    #define LUMP_TASK_YIELD() yield()
+  #endif
+#endif
+
+#ifndef LUMP_PROGMEM
+  #ifdef __AVR__
+    #define LUMP_PROGMEM                 PROGMEM // Places constant data in flash.
+    #define LUMP_READ_PROGMEM_BYTE(addr) pgm_read_byte(addr)
+  #else
+    #define LUMP_PROGMEM
+    #define LUMP_READ_PROGMEM_BYTE(addr) (*(addr))
+  #endif
+#endif
+
+#endif // LUMP_DEVICE_BUILDER_PLATFORM_H
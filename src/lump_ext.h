@@ -75,12 +75,55 @@ typedef enum {
 #define LUMP_INTER_MODE_PAUSE 10
 #define LUMP_UART_INIT_DELAY  5
 
+/* Adaptive speed */
+#ifndef LUMP_SPEED_ERROR_WINDOW
+  #define LUMP_SPEED_ERROR_WINDOW 1000 // Window for counting link errors (milliseconds).
+#endif
+#ifndef LUMP_SPEED_ERROR_LIMIT
+  #define LUMP_SPEED_ERROR_LIMIT 4 // Checksum errors per window that trigger a lower speed.
+#endif
+#ifndef LUMP_SPEED_NACK_LIMIT
+  #define LUMP_SPEED_NACK_LIMIT 30 // NACKs per window that trigger a lower speed (hosts send ~10/s as keep-alive).
+#endif
+
 /* UART settings */
-#define LUMP_UART_BUFFER_SIZE LUMP_MAX_MSG_SIZE + 3
+#define LUMP_UART_BUFFER_SIZE (LUMP_MAX_MSG_SIZE + 3)
 #define LUMP_UART_SPEED_MIN   2400
 #define LUMP_UART_SPEED_MID   57600
 #define LUMP_UART_SPEED_LPF2  115200
+#define LUMP_UART_SPEED_HIGH  230400
 #define LUMP_UART_SPEED_MAX   460800
+#define LUMP_DATA_TX_OFFSET   3 // Offset of data messages in their TX buffer, which aligns the payload to 4 bytes.
+#ifndef LUMP_TX_QUEUE_SIZE
+  #define LUMP_TX_QUEUE_SIZE 64 // Size of the TX queue (bytes), must be at least `LUMP_UART_BUFFER_SIZE + 3`.
+#endif
+#ifndef LUMP_DATA_MSG_ARENA_SIZE
+  #define LUMP_DATA_MSG_ARENA_SIZE 32 // Size of the data message buffers shared by all modes (bytes).
+#endif
+#ifndef LUMP_RX_BURST_SIZE
+  #define LUMP_RX_BURST_SIZE 64 // Maximum number of bytes processed per `run()` call.
+#endif
+#ifndef LUMP_CMD_WRITE_QUEUE_SIZE
+  #define LUMP_CMD_WRITE_QUEUE_SIZE 4 // Number of `LUMP_CMD_WRITE` payloads waiting to be read.
+#endif
+#ifndef LUMP_RX_RING_SIZE
+  #define LUMP_RX_RING_SIZE 0 // Size of the interrupt-fed RX ring (bytes, power of two), `0` disables it.
+#endif
+#ifndef LUMP_THREADED_RUNNER
+  #define LUMP_THREADED_RUNNER 0 // Enables the threaded runner and its sample publisher (`1`) or not (`0`).
+#endif
+#ifndef LUMP_LINK_STATS
+  #define LUMP_LINK_STATS 1 // Enables the link statistics and the run-time instrumentation (`1`) or not (`0`).
+#endif
+#ifndef LUMP_TRACE_SIZE
+  #define LUMP_TRACE_SIZE 0 // Number of records in the trace ring (power of two), `0` disables the tracer.
+#endif
+#ifndef LUMP_CAPTURE_COALESCE_MICROS
+  #define LUMP_CAPTURE_COALESCE_MICROS 50 // Maximum gap between bytes coalesced into one capture record (microseconds).
+#endif
+#ifndef LUMP_EXT_MODE_REFRESH_INTERVAL
+  #define LUMP_EXT_MODE_REFRESH_INTERVAL 1000 // Interval for re-announcing the extended mode (ms).
+#endif
 
 /* Message */
 #define LUMP_MSG_SIZE_SHIFT 3 // Bit shift for LUMP message size.
@@ -88,16 +131,34 @@ typedef enum {
 /* View */
 #define LUMP_VIEW_ALL 255 // Shows all modes in view and data log.
 
+/* Mode combinations */
+#define LUMP_MAX_MODE_COMBOS 8 // Maximum number of mode combinations.
+
+/* LUMP_CMD_WRITE payload */
+#define LUMP_CMD_WRITE_COMBI_SETUP 0x20 // Selects a mode combination.
+
 /* LUMP_CMD_EXT_MODE payload */
 #define LUMP_EXT_MODE_0 0x0 // mode is < 8.
 #define LUMP_EXT_MODE_8 0x8 // mode is >= 8.
 
+/**
+ *  Macro to calculate the largest possible size of a handshake image.
+ *
+ *  The device information takes 13 bytes (type, modes and speed).
+ *  The mode combinations take up to 19 bytes.
+ *  Each mode takes up to 71 bytes (name, value spans, symbol, mapping and format).
+ *
+ *  @param n Number of modes.
+ *  @return Size in bytes.
+ */
+#define LUMP_HANDSHAKE_IMAGE_SIZE(n) (13 + 19 + (n) * 71)
+
 /**
  *  Macro to convert a mode number to an INFO_MODE value.
  *
  *  @param m Mode number.
  *  @return INFO_MODE value.
  */
-#define LUMP_INFO_MODE(m) (m > LUMP_MAX_MODE ? LUMP_INFO_MODE_PLUS_8 : 0x0)
+#define LUMP_INFO_MODE(m) ((m) > LUMP_MAX_MODE ? LUMP_INFO_MODE_PLUS_8 : 0x0)
 
 #endif // LUMP_EXT_H
\ No newline at end of file
@@ -0,0 +1,108 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * Minimal test runner for host tests
+ *
+ * - `TEST(name)` defines a test case, which is run by `main()` in the order of definition.
+ * - `CHECK(cond)` records a failure and continues. `REQUIRE(cond)` records a failure and ends the test case.
+ * - The virtual clock is reset before each test case.
+ *
+ * Include `host/LumpHost.h` (or a sketch built with the Arduino stand-ins) before this header.
+ */
+
+#ifndef LUMP_TEST_H
+#define LUMP_TEST_H
+
+#include "host/HostEmulator.h"
+#include <stdio.h>
+#include <vector>
+
+namespace LumpTest {
+
+  struct TestCase {
+      const char *name;
+      void (*func)();
+  };
+
+  inline std::vector<TestCase> &testCases() {
+    static std::vector<TestCase> cases;
+    return cases;
+  }
+
+  inline int &failures() {
+    static int n = 0;
+    return n;
+  }
+
+  struct Registrar {
+      Registrar(const char *name, void (*func)()) { testCases().push_back({name, func}); }
+  };
+
+  inline void fail(const char *file, int line, const char *expr) {
+    printf("%s:%d: CHECK(%s) failed\n", file, line, expr);
+    ++failures();
+  }
+
+  /**
+   * Runs the device and the emulated host until a condition is met.
+   *
+   * @tparam D Type of the device.
+   * @tparam P Type of the condition.
+   * @param device Device.
+   * @param host Emulated host.
+   * @param pred Condition.
+   * @param timeoutMicros Maximum virtual time to run.
+   * @param stepMicros Virtual time between two calls of `run()`.
+   * @return `true` if the condition has been met, `false` on timeout.
+   */
+  template <typename D, typename P>
+  bool runUntil(D &device, LumpHost::HostEmulator &host, P pred, uint64_t timeoutMicros, uint64_t stepMicros = 100) {
+    uint64_t end = LumpHost::clock().load() + timeoutMicros;
+    while (LumpHost::clock().load() < end) {
+      host.step();
+      device.run();
+      if (pred()) {
+        return true;
+      }
+      LumpHost::advance(stepMicros);
+    }
+    return false;
+  }
+
+} // namespace LumpTest
+
+#define TEST(name)                                                                                                           \
+  static void name();                                                                                                        \
+  static LumpTest::Registrar name##Registrar(#name, name);                                                                   \
+  static void name()
+
+#define CHECK(cond)                                                                                                          \
+  do {                                                                                                                       \
+    if (!(cond)) {                                                                                                           \
+      LumpTest::fail(__FILE__, __LINE__, #cond);                                                                             \
+    }                                                                                                                        \
+  } while (0)
+
+#define REQUIRE(cond)                                                                                                        \
+  do {                                                                                                                       \
+    if (!(cond)) {                                                                                                           \
+      LumpTest::fail(__FILE__, __LINE__, #cond);                                                                             \
+      return;                                                                                                                \
+    }                                                                                                                        \
+  } while (0)
+
+#ifndef LUMP_TEST_NO_MAIN
+int main() {
+  for (auto &t : LumpTest::testCases()) {
+    int before = LumpTest::failures();
+    LumpHost::resetClock();
+    t.func();
+    printf("[%s] %s\n", LumpTest::failures() == before ? "PASS" : "FAIL", t.name);
+  }
+  return LumpTest::failures() ? 1 : 0;
+}
+#endif
+
+#endif // LUMP_TEST_H
@@ -0,0 +1,11 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * Compiles an example sketch only, e.g., with the `-std=gnu++11` default of the Arduino AVR core.
+ *
+ * The sketch is selected with `LUMP_EXAMPLE`.
+ */
+
+#include LUMP_EXAMPLE
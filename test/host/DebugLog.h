@@ -0,0 +1,53 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * Debug output for host builds
+ *
+ * Tests that build the library with debug output define `LUMP_DEBUG_SERIAL=LumpHost::debugLog()`.
+ * The output is collected in `DebugLog::text` instead of being printed.
+ */
+
+#ifndef LUMP_HOST_DEBUG_LOG_H
+#define LUMP_HOST_DEBUG_LOG_H
+
+#include <stdint.h>
+#include <string>
+#include <type_traits>
+
+namespace LumpHost {
+
+  class DebugLog {
+    public:
+      void begin(uint32_t) {}
+      void end() {}
+
+      void print(const char *str) { text += str; }
+
+      template <typename U>
+      typename std::enable_if<std::is_arithmetic<U>::value>::type print(U value) {
+        text += std::to_string(+value);
+      }
+
+      template <typename U>
+      void println(U value) {
+        print(value);
+        text += '\n';
+      }
+
+      /* Gets whether the output contains a string. */
+      bool contains(const char *str) const { return text.find(str) != std::string::npos; }
+
+      std::string text;
+  };
+
+  /* Gets the debug output. */
+  inline DebugLog &debugLog() {
+    static DebugLog log;
+    return log;
+  }
+
+} // namespace LumpHost
+
+#endif // LUMP_HOST_DEBUG_LOG_H
@@ -0,0 +1,202 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * Emulated LEGO host for host builds
+ *
+ * `HostEmulator` plays the host side of a `MockSerial`:
+ * - LPF2 hosts send `LUMP_CMD_SPEED` until the device acknowledges it. EV3 hosts stay silent during AutoID.
+ * - Every message sent by the device is parsed and checked. The handshake ends with the device's ACK, which is
+ *   answered with an ACK.
+ * - While connected, a NACK is sent every `keepAliveMicros` as keep-alive, and data messages are collected.
+ * - A new `LUMP_CMD_TYPE` message means that the device restarted the handshake.
+ */
+
+#ifndef LUMP_HOST_HOST_EMULATOR_H
+#define LUMP_HOST_HOST_EMULATOR_H
+
+#include "MockSerial.h"
+#include "lump.h"
+#include <initializer_list>
+#include <vector>
+
+namespace LumpHost {
+
+  /* Represents a message received by the host. */
+  struct Frame {
+      std::vector<uint8_t> bytes; // Whole message, including the header and the checksum.
+      uint64_t micros;            // Time the last byte was received.
+
+      uint8_t header() const { return bytes[0]; }
+      uint8_t type() const { return bytes[0] & LUMP_MSG_TYPE_MASK; }
+      uint8_t cmd() const { return bytes[0] & LUMP_MSG_CMD_MASK; }
+  };
+
+  /**
+   * Calculates the checksum of a message.
+   *
+   * @param msg Message without the checksum.
+   * @param size Size of the message.
+   * @return Checksum.
+   */
+  inline uint8_t checksum(const uint8_t *msg, size_t size) {
+    uint8_t c = 0xff;
+    while (size--) {
+      c ^= *msg++;
+    }
+    return c;
+  }
+
+  /**
+   * Gets the full size of a message from its header.
+   *
+   * @param header Header byte.
+   * @return Size in bytes.
+   */
+  inline size_t messageSize(uint8_t header) {
+    switch (header & LUMP_MSG_TYPE_MASK) {
+      case LUMP_MSG_TYPE_SYS:
+        return 1;
+      case LUMP_MSG_TYPE_INFO:
+        return LUMP_MSG_SIZE(header) + 3;
+      default:
+        return LUMP_MSG_SIZE(header) + 2;
+    }
+  }
+
+  class HostEmulator {
+    public:
+      enum class Kind {
+        Lpf2, // SPIKE/Powered Up hubs.
+        Ev3,  // EV3 bricks.
+      };
+
+      HostEmulator(MockSerial &serial, Kind kind = Kind::Lpf2) : serial{serial}, kind{kind} {}
+
+      /**
+       * Processes the bytes received since the last call and sends the due messages.
+       * Call after each advance of the virtual clock.
+       */
+      void step() {
+        uint64_t now = clock().load();
+
+        for (const WireByte &b : serial.hostRead()) {
+          partial.push_back(b.value);
+          if (partial.size() == messageSize(partial[0])) {
+            process(Frame{partial, b.micros});
+            partial.clear();
+          }
+        }
+
+        if (kind == Kind::Lpf2 && !speedAcked && now - lastSpeedMicros >= 10000) {
+          lastSpeedMicros = now;
+          sendCmd(LUMP_CMD_SPEED, {0x00, 0xc2, 0x01, 0x00}); // 115200
+        }
+
+        if (connected && keepAlive && now - lastNackMicros >= keepAliveMicros) {
+          lastNackMicros = now;
+          serial.hostWrite(LUMP_SYS_NACK);
+        }
+      }
+
+      /**
+       * Sends a command message.
+       *
+       * @param cmd Command.
+       * @param payload Payload (1, 2, 4, ... bytes).
+       */
+      void sendCmd(uint8_t cmd, std::initializer_list<uint8_t> payload) {
+        sendMsg(LUMP_MSG_TYPE_CMD, cmd, std::vector<uint8_t>(payload));
+      }
+
+      /**
+       * Sends a message with a power-of-two payload.
+       *
+       * @param type Message type.
+       * @param cmd Command or mode.
+       * @param payload Payload, zero-padded to a power of two.
+       */
+      void sendMsg(uint8_t type, uint8_t cmd, std::vector<uint8_t> payload) {
+        uint8_t log2 = 0;
+        while ((1u << log2) < payload.size()) {
+          ++log2;
+        }
+        payload.resize(1u << log2, 0);
+
+        std::vector<uint8_t> msg;
+        msg.push_back(type | (log2 << 3) | cmd);
+        msg.insert(msg.end(), payload.begin(), payload.end());
+        msg.push_back(checksum(msg.data(), msg.size()));
+        serial.hostWrite(msg.data(), msg.size());
+      }
+
+      /* Selects a mode. */
+      void selectMode(uint8_t mode) { sendCmd(LUMP_CMD_SELECT, {mode}); }
+
+      /* State */
+      bool connected{false};
+      bool speedAcked{false};
+      bool keepAlive{true};
+      uint64_t keepAliveMicros{100000};
+      uint32_t handshakes{0};     // Completed handshakes.
+      uint32_t badChecksums{0};   // Messages from the device with a wrong checksum.
+      uint64_t handshakeStart{0}; // Time the `LUMP_CMD_TYPE` message of the last handshake was received.
+      uint64_t handshakeEnd{0};   // Time the final ACK of the last handshake was received.
+      std::vector<Frame> handshakeFrames; // Messages of the last handshake.
+      std::vector<Frame> dataFrames;      // Data messages received while connected.
+      uint8_t extMode{0};                 // Last extended mode announced by the device.
+
+    private:
+      void process(const Frame &frame) {
+        if (frame.type() != LUMP_MSG_TYPE_SYS &&
+            checksum(frame.bytes.data(), frame.bytes.size() - 1) != frame.bytes.back()) {
+          ++badChecksums;
+          return;
+        }
+
+        if (frame.type() == LUMP_MSG_TYPE_SYS) {
+          if (frame.header() == LUMP_SYS_ACK) {
+            if (inHandshake) {
+              /* End of the handshake. */
+              serial.hostWrite(LUMP_SYS_ACK);
+              inHandshake    = false;
+              connected      = true;
+              handshakeEnd   = frame.micros;
+              lastNackMicros = clock().load();
+              ++handshakes;
+            } else {
+              speedAcked = true; // Reply to `LUMP_CMD_SPEED`.
+            }
+          }
+          return;
+        }
+
+        if (frame.type() == LUMP_MSG_TYPE_CMD && frame.cmd() == LUMP_CMD_TYPE) {
+          /* Start of a (new) handshake. */
+          inHandshake    = true;
+          connected      = false;
+          handshakeStart = frame.micros;
+          handshakeFrames.clear();
+        }
+
+        if (inHandshake) {
+          handshakeFrames.push_back(frame);
+        } else if (frame.type() == LUMP_MSG_TYPE_CMD && frame.cmd() == LUMP_CMD_EXT_MODE) {
+          extMode = frame.bytes[1];
+        } else if (frame.type() == LUMP_MSG_TYPE_DATA) {
+          dataFrames.push_back(frame);
+        }
+      }
+
+      MockSerial &serial;
+      Kind kind;
+      std::vector<uint8_t> partial;
+      bool inHandshake{false};
+      uint64_t lastSpeedMicros{0};
+      uint64_t lastNackMicros{0};
+  };
+
+} // namespace LumpHost
+
+#endif // LUMP_HOST_HOST_EMULATOR_H
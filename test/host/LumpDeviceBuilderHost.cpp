@@ -0,0 +1,9 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/* Builds the non-template part of the library for the host. */
+
+#include "LumpHost.h"
+
+#include "../../src/LumpDeviceBuilder.cpp"
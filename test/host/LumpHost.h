@@ -0,0 +1,26 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * Host build of the LUMP Device Builder Library
+ *
+ * Include this header instead of `LumpDeviceBuilder.h` to build the library on a host with the virtual clock,
+ * the mock UART and the emulated host. Library options (e.g., `LUMP_RX_RING_SIZE`) are defined before including it.
+ */
+
+#ifndef LUMP_HOST_H
+#define LUMP_HOST_H
+
+#define LUMP_HOST_BUILD
+#define LUMP_MILLIS() LumpHost::millis()
+#define LUMP_MICROS() LumpHost::micros()
+
+#include "VirtualClock.h"
+
+#include "DebugLog.h"
+#include "HostEmulator.h"
+#include "MockSerial.h"
+#include <LumpDeviceBuilder.h>
+
+#endif // LUMP_HOST_H
@@ -0,0 +1,210 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * Mock UART for host builds
+ *
+ * `MockSerial` has the `HardwareSerial` surface used by the library and models a UART on the virtual clock:
+ * - Written bytes go into a TX FIFO of `txFifoSize` bytes and leave it one byte time (10 bits) apart.
+ *   Writing into a full FIFO or calling `flush()` blocks: the virtual clock is advanced until there is room, and the
+ *   time is added to `blockedMicros`.
+ * - Bytes written by the host side (`hostWrite()`) arrive one byte time apart.
+ */
+
+#ifndef LUMP_HOST_MOCK_SERIAL_H
+#define LUMP_HOST_MOCK_SERIAL_H
+
+#include "VirtualClock.h"
+#include <deque>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+namespace LumpHost {
+
+  /* Represents a byte on the wire. */
+  struct WireByte {
+      uint8_t value;
+      uint64_t micros; // Time the byte has been completely transmitted.
+  };
+
+  class MockSerial {
+    public:
+      /**
+       * Constructs a mock UART.
+       *
+       * @param txFifoSize Size of the TX FIFO, as reported by `availableForWrite()` when empty.
+       */
+      explicit MockSerial(int txFifoSize = 64) : txFifoSize{txFifoSize} {}
+
+      /* Device side (`HardwareSerial` surface) */
+      void begin(uint32_t baud) {
+        std::lock_guard<std::mutex> lock(mutex);
+        speed = baud;
+        ++numBegins;
+      }
+
+      void end() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &b : txFifo) {
+          wire.push_back(b); // The remaining bytes are sent without blocking the caller.
+        }
+        txFifo.clear();
+        rx.clear();
+      }
+
+      int available() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return arrived();
+      }
+
+      int read() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!arrived()) {
+          return -1;
+        }
+        uint8_t c = rx.front().value;
+        rx.pop_front();
+        return c;
+      }
+
+      int peek() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return arrived() ? rx.front().value : -1;
+      }
+
+      size_t write(uint8_t c) {
+        std::lock_guard<std::mutex> lock(mutex);
+        update();
+        while (static_cast<int>(txFifo.size()) >= txFifoSize) {
+          block(txFifo.front().micros);
+        }
+
+        uint64_t start = txFifo.empty() ? clock().load() : txFifo.back().micros;
+        if (start < lineFree) {
+          start = lineFree;
+        }
+        txFifo.push_back({c, start + byteMicros()});
+        lineFree = txFifo.back().micros;
+        ++txBytes;
+        return 1;
+      }
+
+      size_t write(const uint8_t *buffer, size_t size) {
+        ++numWrites;
+        for (size_t i = 0; i < size; ++i) {
+          write(buffer[i]);
+        }
+        return size;
+      }
+
+      int availableForWrite() {
+        std::lock_guard<std::mutex> lock(mutex);
+        update();
+        return txFifoSize - static_cast<int>(txFifo.size());
+      }
+
+      void flush() {
+        std::lock_guard<std::mutex> lock(mutex);
+        update();
+        if (!txFifo.empty()) {
+          block(txFifo.back().micros);
+        }
+      }
+
+      /* Host side */
+
+      /**
+       * Sends bytes to the device. They arrive one byte time apart, after the previous host bytes.
+       *
+       * @param data Bytes.
+       * @param size Number of bytes.
+       */
+      void hostWrite(const uint8_t *data, size_t size) {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t t = clock().load();
+        if (!rx.empty() && rx.back().micros > t) {
+          t = rx.back().micros;
+        }
+        for (size_t i = 0; i < size; ++i) {
+          t += byteMicros();
+          rx.push_back({data[i], t});
+        }
+      }
+
+      void hostWrite(uint8_t c) { hostWrite(&c, 1); }
+
+      /**
+       * Takes the bytes that have left the device since the last call.
+       *
+       * @return Bytes on the wire, in order.
+       */
+      std::vector<WireByte> hostRead() {
+        std::lock_guard<std::mutex> lock(mutex);
+        update();
+        std::vector<WireByte> bytes;
+        bytes.swap(wire);
+        return bytes;
+      }
+
+      /* Gets the time needed to transmit one byte (8N1) at the current speed. */
+      uint64_t byteMicros() const { return speed ? (10000000ULL + speed - 1) / speed : 0; }
+
+      /* State */
+      int txFifoSize;
+      uint32_t speed{0};
+      uint32_t numBegins{0};
+      uint64_t txBytes{0};       // Bytes written by the device.
+      uint64_t numWrites{0};     // Calls to the buffer variant of `write()`.
+      uint64_t blockedMicros{0}; // Total time the device was blocked in `write()` or `flush()`.
+      uint64_t maxBlockMicros{0};
+
+    private:
+      /* Moves the transmitted bytes from the TX FIFO to the wire. */
+      void update() {
+        uint64_t now = clock().load();
+        while (!txFifo.empty() && txFifo.front().micros <= now) {
+          wire.push_back(txFifo.front());
+          txFifo.pop_front();
+        }
+      }
+
+      /* Advances the virtual clock as a blocking call would. */
+      void block(uint64_t until) {
+        uint64_t now = clock().load();
+        if (until > now) {
+          advance(until - now);
+          blockedMicros += until - now;
+          if (until - now > maxBlockMicros) {
+            maxBlockMicros = until - now;
+          }
+        }
+        update();
+      }
+
+      /* Gets the number of received bytes that have arrived. */
+      int arrived() {
+        uint64_t now = clock().load();
+        int n        = 0;
+        for (auto &b : rx) {
+          if (b.micros > now) {
+            break;
+          }
+          ++n;
+        }
+        return n;
+      }
+
+      std::mutex mutex;
+      std::deque<WireByte> txFifo;
+      std::deque<WireByte> rx;
+      std::vector<WireByte> wire;
+      uint64_t lineFree{0};
+  };
+
+} // namespace LumpHost
+
+#endif // LUMP_HOST_MOCK_SERIAL_H
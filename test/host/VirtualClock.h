@@ -0,0 +1,51 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * Virtual clock for host builds
+ *
+ * Time only moves when a test advances it, so simulations are deterministic and independent of the host speed.
+ */
+
+#ifndef LUMP_HOST_VIRTUAL_CLOCK_H
+#define LUMP_HOST_VIRTUAL_CLOCK_H
+
+#include <atomic>
+#include <stdint.h>
+
+namespace LumpHost {
+
+  /**
+   * Gets the current virtual time.
+   *
+   * @return Time in microseconds since the start of the simulation.
+   */
+  inline std::atomic<uint64_t> &clock() {
+    static std::atomic<uint64_t> now{0};
+    return now;
+  }
+
+  /* Gets the current virtual time in microseconds (wraps like `micros()`). */
+  inline uint32_t micros() { return static_cast<uint32_t>(clock().load()); }
+
+  /* Gets the current virtual time in milliseconds (wraps like `millis()`). */
+  inline uint32_t millis() { return static_cast<uint32_t>(clock().load() / 1000); }
+
+  /**
+   * Advances the virtual time.
+   *
+   * @param us Time in microseconds.
+   */
+  inline void advance(uint64_t us) { clock().fetch_add(us); }
+
+  /**
+   * Resets the virtual time.
+   *
+   * @param us New time in microseconds.
+   */
+  inline void resetClock(uint64_t us = 0) { clock().store(us); }
+
+} // namespace LumpHost
+
+#endif // LUMP_HOST_VIRTUAL_CLOCK_H
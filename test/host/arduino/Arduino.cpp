@@ -0,0 +1,9 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#include "Arduino.h"
+
+HardwareSerial Serial;
+HardwareSerial Serial0;
+HardwareSerial Serial1;
@@ -0,0 +1,124 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * Host stand-ins for the Arduino core
+ *
+ * Covers the Arduino and FreeRTOS APIs used by the library and its examples, so sketches build on a host
+ * without `LUMP_HOST_BUILD`:
+ * - Time functions run on the virtual clock. `delay()` advances it and yields to other tasks.
+ * - `HardwareSerial` is the mock UART. `Serial`, `Serial0` and `Serial1` are available.
+ * - Pins are simulated: `digitalWrite()` and `digitalRead()` share a level per pin, and `analogRead()` returns the
+ *   value set with `LumpHost::setAnalog()`.
+ * - `xTaskCreatePinnedToCore()` starts a `std::thread`, which is joined by `LumpHost::joinTasks()`.
+ */
+
+#ifndef LUMP_HOST_ARDUINO_H
+#define LUMP_HOST_ARDUINO_H
+
+#include "../MockSerial.h"
+#include "../VirtualClock.h"
+#include <algorithm>
+#include <ctype.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+using std::max;
+using std::min;
+
+#define LOW          0x0
+#define HIGH         0x1
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+
+typedef LumpHost::MockSerial HardwareSerial;
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial0;
+extern HardwareSerial Serial1;
+
+namespace LumpHost {
+
+  constexpr uint8_t numPins = 64;
+
+  /* Simulated pin levels and analog values. */
+  struct Pins {
+      uint8_t mode[numPins];
+      uint8_t level[numPins];
+      int analog[numPins];
+  };
+
+  inline Pins &pins() {
+    static Pins p{};
+    return p;
+  }
+
+  /**
+   * Sets the value returned by `analogRead()`.
+   *
+   * @param pin Pin number.
+   * @param value Raw value.
+   */
+  inline void setAnalog(uint8_t pin, int value) { pins().analog[pin % numPins] = value; }
+
+  inline std::vector<std::thread> &tasks() {
+    static std::vector<std::thread> t;
+    return t;
+  }
+
+  /* Waits for all tasks started with `xTaskCreatePinnedToCore()` to return. */
+  inline void joinTasks() {
+    for (auto &t : tasks()) {
+      t.join();
+    }
+    tasks().clear();
+  }
+
+} // namespace LumpHost
+
+/* Time */
+inline unsigned long millis() { return LumpHost::millis(); }
+inline unsigned long micros() { return LumpHost::micros(); }
+inline void delay(unsigned long ms) {
+  LumpHost::advance(ms * 1000ULL);
+  std::this_thread::yield(); // Lets other tasks run, as a blocking delay would.
+}
+inline void delayMicroseconds(unsigned int us) { LumpHost::advance(us); }
+inline void yield() { std::this_thread::yield(); }
+
+/* Pins */
+inline void pinMode(uint8_t pin, uint8_t mode) { LumpHost::pins().mode[pin % LumpHost::numPins] = mode; }
+inline void digitalWrite(uint8_t pin, uint8_t value) { LumpHost::pins().level[pin % LumpHost::numPins] = value; }
+inline int digitalRead(uint8_t pin) { return LumpHost::pins().level[pin % LumpHost::numPins]; }
+inline int analogRead(uint8_t pin) { return LumpHost::pins().analog[pin % LumpHost::numPins]; }
+
+/* FreeRTOS */
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+inline int xTaskCreatePinnedToCore(
+    TaskFunction_t func,
+    const char *name,
+    uint32_t stackSize,
+    void *param,
+    unsigned priority,
+    TaskHandle_t *handle,
+    int core
+) {
+  LumpHost::tasks().emplace_back(func, param);
+  if (handle) {
+    *handle = nullptr;
+  }
+  return 1; // pdPASS
+}
+
+inline void vTaskDelay(uint32_t ticks) { std::this_thread::yield(); }
+
+#endif // LUMP_HOST_ARDUINO_H
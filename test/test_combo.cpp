@@ -0,0 +1,63 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/* Mode combinations. */
+
+#include "host/LumpHost.h"
+
+#include "LumpTest.h"
+
+using LumpHost::HostEmulator;
+using LumpHost::MockSerial;
+using LumpTest::runUntil;
+
+static const LumpMode modes[]{
+    {"A", DATA16, 1, 4, 0},
+    {"B", DATA16, 1, 4, 0},
+    {"C", DATA16, 2, 4, 0},
+};
+
+static const uint16_t combos[]{0b101, 0b011};
+
+TEST(lastEntryForModeZero) {
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 115200, modes, 3);
+  device.setModeCombos(combos, 2);
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 5000000));
+
+  /* Combination 0 holds 3 values. The last requested one is mode 0, dataset 0 (0x00), followed by padding. */
+  host.sendMsg(LUMP_MSG_TYPE_CMD, LUMP_CMD_WRITE, {LUMP_CMD_WRITE_COMBI_SETUP, 0, 0x20, 0x21, 0x00});
+  REQUIRE(runUntil(device, host, [&] { return device.hasComboSelect(); }, 10000));
+  CHECK(device.isComboMode());
+  CHECK(device.combo() == 0);
+
+  int16_t a[]{0x1111};
+  int16_t c[]{0x2222, 0x3333};
+  const void *data[]{a, nullptr, c};
+  size_t numFrames = host.dataFrames.size();
+  device.sendCombo(data);
+  REQUIRE(runUntil(device, host, [&] { return host.dataFrames.size() > numFrames; }, 10000));
+
+  const std::vector<uint8_t> expected{0x22, 0x22, 0x33, 0x33, 0x11, 0x11, 0x00, 0x00};
+  auto &bytes = host.dataFrames.back().bytes;
+  CHECK(std::vector<uint8_t>(bytes.begin() + 1, bytes.end() - 1) == expected);
+}
+
+TEST(invalidCombo) {
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 115200, modes, 3);
+  device.setModeCombos(combos, 2);
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 5000000));
+
+  host.sendMsg(LUMP_MSG_TYPE_CMD, LUMP_CMD_WRITE, {LUMP_CMD_WRITE_COMBI_SETUP, 2, 0x00, 0x10});
+  runUntil(device, host, [&] { return false; }, 10000);
+  CHECK(!device.hasComboSelect());
+  CHECK(!device.isComboMode());
+}
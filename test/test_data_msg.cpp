@@ -0,0 +1,64 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/* Data message buffers and the TX queue. Built with debug output (`LUMP_DEBUG_SERIAL`). */
+
+#include "host/LumpHost.h"
+
+#include "LumpTest.h"
+
+using LumpHost::debugLog;
+using LumpHost::HostEmulator;
+using LumpHost::MockSerial;
+using LumpTest::runUntil;
+
+/* Each mode needs 32 bytes, but the default arena only holds 32. */
+static constexpr LumpMode modes[]{
+    {"A", DATA32, 8, 4, 0, "", false, false, false, LUMP_INFO_MAPPING_NONE, LUMP_INFO_MAPPING_ABS},
+    {"B", DATA32, 8, 4, 0, "", false, false, false, LUMP_INFO_MAPPING_NONE, LUMP_INFO_MAPPING_ABS},
+    {"C", DATA32, 8, 4, 0},
+};
+
+static_assert(lumpDataMsgFootprint(modes) == 64, "Modes A and B need a buffer each");
+
+TEST(arenaTooSmall) {
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 115200, modes, 3);
+  debugLog().text.clear();
+  device.begin();
+
+  CHECK(device.dataMsgFootprint() == 64);
+  CHECK(debugLog().contains("[Error] LUMP_DATA_MSG_ARENA_SIZE is too small, required: 64"));
+
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 5000000));
+
+  std::vector<uint8_t> payload(32, 0x5a);
+  host.sendMsg(LUMP_MSG_TYPE_DATA, 0, payload);
+  host.sendMsg(LUMP_MSG_TYPE_DATA, 1, payload);
+  runUntil(device, host, [&] { return false; }, 10000);
+
+  CHECK(device.hasDataMsg(0));
+  CHECK(!device.hasDataMsg(1));
+  CHECK(device.rxDataDropCount() == 1);
+}
+
+TEST(txQueueFull) {
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 115200, modes, 3);
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 5000000));
+
+  /* 34-byte data messages of alternating modes, faster than the UART FIFO and the TX queue can take them. */
+  int32_t data[8]{};
+  debugLog().text.clear();
+  for (uint8_t i = 0; i < 6; ++i) {
+    device.send(data, 8, i % 3);
+  }
+
+  CHECK(device.txDropCount() > 0);
+  CHECK(debugLog().contains("[Warn] TX queue full, data message dropped, mode: "));
+}
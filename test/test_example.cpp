@@ -0,0 +1,37 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * Runs an example sketch against an emulated LPF2 host.
+ *
+ * The sketch is selected with `LUMP_EXAMPLE` and built with the Arduino stand-ins in `host/arduino`.
+ * It must define `DEVICE_SERIAL` and `device`.
+ */
+
+#include LUMP_EXAMPLE
+
+#include "LumpTest.h"
+
+TEST(example) {
+  LumpHost::HostEmulator host(DEVICE_SERIAL);
+  setup();
+
+  /* Runs the sketch until the handshake is done and the device sends data. */
+  uint64_t end = LumpHost::clock().load() + 5000000;
+  while (LumpHost::clock().load() < end && (!host.connected || host.dataFrames.size() < 3)) {
+    host.step();
+    loop();
+    LumpHost::advance(100);
+  }
+
+#if LUMP_THREADED_RUNNER
+  device.stopProtocolTask();
+  LumpHost::joinTasks();
+#endif
+
+  CHECK(host.connected);
+  CHECK(host.handshakes == 1);
+  CHECK(host.badChecksums == 0);
+  CHECK(host.dataFrames.size() >= 3);
+}
@@ -0,0 +1,312 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/* Handshake with emulated LPF2 and EV3 hosts. */
+
+#include "host/LumpHost.h"
+
+#include "LumpTest.h"
+
+using LumpHost::HostEmulator;
+using LumpHost::MockSerial;
+using LumpTest::runUntil;
+
+static const LumpMode modes[]{
+    {"Analog", DATA16, 1, 4, 0, "raw", {0, 4095}, {0, 100}, {0, 4095}},
+    {"Digital", DATA8, 1, 1, 0, "", {0, 1}, false, {0, 1}},
+    {"Pair", DATA32, 2, 6, 0, "mm", {0, 1000}, false, false},
+};
+
+static const uint8_t numModes = sizeof(modes) / sizeof(LumpMode);
+
+TEST(lpf2Handshake) {
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 115200, modes, numModes);
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 5000000));
+  CHECK(host.connected);
+  CHECK(host.handshakes == 1);
+  CHECK(host.badChecksums == 0);
+  CHECK(serial.speed == 115200);
+
+  /* Type, modes, speed, version, then name, spans, symbol and format of each mode (from the last one). */
+  REQUIRE(!host.handshakeFrames.empty());
+  CHECK(host.handshakeFrames[0].header() == (LUMP_MSG_TYPE_CMD | LUMP_CMD_TYPE));
+  CHECK(host.handshakeFrames[0].bytes[1] == 68);
+
+  uint8_t firstNameMode = 0xff;
+  for (auto &f : host.handshakeFrames) {
+    if (f.type() == LUMP_MSG_TYPE_INFO && (f.bytes[1] & ~LUMP_INFO_MODE_PLUS_8) == LUMP_INFO_NAME) {
+      firstNameMode = f.cmd();
+      break;
+    }
+  }
+  CHECK(firstNameMode == numModes - 1);
+
+  /* The keep-alive NACKs keep the link up. */
+  CHECK(!runUntil(device, host, [&] { return device.state() != LumpDeviceState::Communicating; }, 2000000));
+  CHECK(host.handshakes == 1);
+}
+
+TEST(ev3Handshake) {
+  MockSerial serial;
+  HostEmulator host(serial, HostEmulator::Kind::Ev3);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 57600, modes, numModes);
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 10000000));
+  CHECK(host.handshakes == 1);
+  CHECK(host.badChecksums == 0);
+  CHECK(serial.speed == 57600);
+
+  /* EV3 hosts detect the device at `LUMP_UART_SPEED_MIN`, which takes a while. */
+  CHECK(host.handshakeEnd - host.handshakeStart > 100000);
+}
+
+TEST(keepAliveTimeout) {
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 115200, modes, numModes);
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return host.connected; }, 5000000));
+
+  /* Without keep-alive NACKs, the device restarts the handshake. */
+  host.keepAlive = false;
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Reset; }, 2000000));
+  host.keepAlive = true;
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 5000000));
+  CHECK(host.handshakes == 2);
+}
+
+TEST(handshakeImageReplay) {
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 115200, modes, numModes);
+  static uint8_t image[LUMP_HANDSHAKE_IMAGE_SIZE(numModes)];
+  device.setHandshakeImage(image, sizeof(image));
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return host.handshakes == 1; }, 5000000));
+  auto recorded = host.handshakeFrames;
+
+  /* The second handshake is replayed from the image and must be identical. */
+  host.keepAlive = false;
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Reset; }, 2000000));
+  host.keepAlive = true;
+  REQUIRE(runUntil(device, host, [&] { return host.handshakes == 2; }, 5000000));
+
+  REQUIRE(recorded.size() == host.handshakeFrames.size());
+  for (size_t i = 0; i < recorded.size(); ++i) {
+    CHECK(recorded[i].bytes == host.handshakeFrames[i].bytes);
+  }
+  CHECK(host.badChecksums == 0);
+}
+
+static const LumpMode floatModes[]{
+    {"Float 0", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+    {"Float 1", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+    {"Float 2", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+    {"Float 3", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+    {"Float 4", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+    {"Float 5", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+    {"Float 6", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+    {"Float 7", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+};
+
+TEST(handshakeDoesNotBlock) {
+  /* At 2400 baud, the information of one mode takes ~400 ms to send, so the TX queue fills up. */
+  MockSerial serial;
+  HostEmulator host(serial, HostEmulator::Kind::Ev3);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 57600, floatModes, 8);
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 20000000, 1000));
+  CHECK(serial.maxBlockMicros == 0);
+  CHECK(host.handshakes == 1);
+  CHECK(host.badChecksums == 0);
+}
+
+TEST(handshakeImageDoesNotBlock) {
+  /* The information of one mode never fits into the TX queue at once. */
+  MockSerial serial;
+  HostEmulator host(serial, HostEmulator::Kind::Ev3);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 57600, floatModes, 8);
+  static uint8_t image[LUMP_HANDSHAKE_IMAGE_SIZE(8)];
+  device.setHandshakeImage(image, sizeof(image));
+  device.setAdaptiveSpeed(false);
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 20000000, 1000));
+  auto recorded = host.handshakeFrames;
+
+  host.keepAlive = false;
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Reset; }, 2000000, 1000));
+  host.keepAlive       = true;
+  serial.blockedMicros  = 0;
+  serial.maxBlockMicros = 0;
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 20000000, 1000));
+
+  CHECK(serial.maxBlockMicros == 0);
+  REQUIRE(recorded.size() == host.handshakeFrames.size());
+  for (size_t i = 0; i < recorded.size(); ++i) {
+    CHECK(recorded[i].bytes == host.handshakeFrames[i].bytes);
+  }
+  CHECK(host.badChecksums == 0);
+}
+
+TEST(nackDuringHandshakeImage) {
+  /* A NACK sent while the image is streaming must land between messages, not inside one. */
+  MockSerial serial;
+  HostEmulator host(serial, HostEmulator::Kind::Ev3);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 57600, floatModes, 8);
+  static uint8_t image[LUMP_HANDSHAKE_IMAGE_SIZE(8)];
+  device.setHandshakeImage(image, sizeof(image));
+  device.setAdaptiveSpeed(false);
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 20000000, 1000));
+  auto recorded = host.handshakeFrames;
+
+  host.keepAlive = false;
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Reset; }, 2000000, 1000));
+  host.keepAlive = true;
+
+  /* Injects a select command with a bad checksum every 50 ms while the handshake streams. */
+  const uint8_t corrupt[]{0x43, 0x00, 0x00};
+  uint64_t lastInject = LumpHost::clock().load();
+  REQUIRE(runUntil(
+      device, host,
+      [&] {
+        uint64_t now = LumpHost::clock().load();
+        if (device.state() >= LumpDeviceState::SendingType && device.state() <= LumpDeviceState::SendingFormat &&
+            now - lastInject >= 50000) {
+          lastInject = now;
+          serial.hostWrite(corrupt, sizeof(corrupt));
+        }
+        return device.state() == LumpDeviceState::Communicating;
+      },
+      20000000, 1000));
+
+  CHECK(device.linkStats().nacksSent > 0);
+  CHECK(host.badChecksums == 0);
+  REQUIRE(recorded.size() == host.handshakeFrames.size());
+  for (size_t i = 0; i < recorded.size(); ++i) {
+    CHECK(recorded[i].bytes == host.handshakeFrames[i].bytes);
+  }
+}
+
+/* Covers power, flags in the name, symbols, negative and fractional spans, more than 8 modes and combinations. */
+static constexpr LumpMode flashModes[]{
+    {"Power", DATA16, 1, 4, 0, "raw", {0, 4095}, {0, 100}, {0, 4095}, LUMP_INFO_MAPPING_NONE, LUMP_INFO_MAPPING_NONE, true},
+    {"Flags\0\x20\x00\x00\x00\x00", DATA8, 1, 1, 0, "", {0, 1}, false, false, LUMP_INFO_MAPPING_NONE,
+     LUMP_INFO_MAPPING_NONE, false, true},
+    {"Signed", DATA32, 2, 6, 1, "deg", {-36000, 36000}, {-100, 100}, {-360, 360}},
+    {"Frac", DATAF, 3, 5, 3, "V", {-0.5f, 2.25f}, false, {0.001f, 1e6f}},
+    {"Zero", DATA16, 1, 3, 0, "", {-0.0f, 0}, false, false},
+    {"Map", DATA8, 4, 3, 0, "pct", false, {0, 100}, false, LUMP_INFO_MAPPING_ABS, LUMP_INFO_MAPPING_REL},
+    {"Mode 6", DATA16, 1, 4, 0},
+    {"Mode 7", DATA16, 1, 4, 0},
+    {"Mode 8", DATA32, 1, 6, 2, "mm", {-1000, 1000}},
+    {"Mode 9", DATAF, 8, 8, 2, "mm", {-1000, 1000}, {-100, 100}, {-1, 1}},
+};
+
+static constexpr uint16_t flashCombos[]{0b101, 0b1000000011};
+
+LUMP_HANDSHAKE_IMAGE(flashImage, 68, 115200, 3, flashModes, flashCombos);
+
+static_assert(sizeof(flashImage) <= LUMP_HANDSHAKE_IMAGE_SIZE(10), "The image must fit the RAM buffer");
+
+/* Runs the first handshake of a device with the flash modes, and records its messages into `frames`. */
+static void flashHandshake(HostEmulator::Kind kind, bool flash, std::vector<LumpHost::Frame> &frames,
+                           uint8_t *buffer = nullptr, uint16_t size = 0) {
+  MockSerial serial;
+  HostEmulator host(serial, kind);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 115200, flashModes, 10, 3);
+  device.setModeCombos(flashCombos, 2);
+  if (flash) {
+    device.setHandshakeImage(flashImage);
+  } else if (buffer) {
+    device.setHandshakeImage(buffer, size);
+  }
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 20000000, 1000));
+  CHECK(host.handshakes == 1);
+  CHECK(host.badChecksums == 0);
+  CHECK(serial.maxBlockMicros == 0);
+  frames = host.handshakeFrames;
+}
+
+TEST(flashHandshakeImageMatchesRecorded) {
+  static uint8_t buffer[LUMP_HANDSHAKE_IMAGE_SIZE(10)];
+  std::vector<LumpHost::Frame> frames;
+  flashHandshake(HostEmulator::Kind::Lpf2, false, frames, buffer, sizeof(buffer));
+
+  for (size_t i = 0; i < sizeof(flashImage); ++i) {
+    CHECK(buffer[i] == flashImage.bytes[i]);
+  }
+}
+
+TEST(flashHandshakeImage) {
+  for (HostEmulator::Kind kind : {HostEmulator::Kind::Lpf2, HostEmulator::Kind::Ev3}) {
+    std::vector<LumpHost::Frame> serialized, streamed;
+    flashHandshake(kind, false, serialized);
+    flashHandshake(kind, true, streamed);
+
+    REQUIRE(serialized.size() == streamed.size());
+    for (size_t i = 0; i < serialized.size(); ++i) {
+      CHECK(serialized[i].bytes == streamed[i].bytes);
+    }
+  }
+}
+
+TEST(flashHandshakeImageIsStreamed) {
+  /* The device modes differ from the image in a name only. The image is streamed instead of the device modes. */
+  std::vector<LumpMode> renamed(std::begin(flashModes), std::end(flashModes));
+  renamed[6] = LumpMode("Other", DATA16, 1, 4, 0);
+
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 115200, renamed.data(), 10, 3);
+  device.setModeCombos(flashCombos, 2);
+  device.setHandshakeImage(flashImage);
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return host.handshakes == 1; }, 5000000));
+  std::vector<uint8_t> streamed;
+  for (const LumpHost::Frame &frame : host.handshakeFrames) {
+    streamed.insert(streamed.end(), frame.bytes.begin(), frame.bytes.end());
+  }
+  CHECK(streamed == std::vector<uint8_t>(std::begin(flashImage.bytes), std::end(flashImage.bytes)));
+}
+
+TEST(mismatchedFlashHandshakeImage) {
+  /* The image has 10 modes, the device 3. The image is ignored and the handshake is serialized. */
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 115200, flashModes, 3);
+  device.setHandshakeImage(flashImage);
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 5000000));
+  CHECK(host.badChecksums == 0);
+}
+
+TEST(flashHandshakeImageAtAnotherSpeed) {
+  /* The image advertises 115200 baud, the device 57600. The handshake is serialized at the device speed. */
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 57600, flashModes, 10, 3);
+  device.setModeCombos(flashCombos, 2);
+  device.setHandshakeImage(flashImage);
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return host.handshakes == 1; }, 5000000));
+  REQUIRE(host.handshakeFrames.size() > 2);
+  CHECK(host.handshakeFrames[2].bytes == std::vector<uint8_t>({0x52, 0x00, 0xe1, 0x00, 0x00, 0x4c}));
+  CHECK(host.badChecksums == 0);
+}
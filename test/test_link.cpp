@@ -0,0 +1,79 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/* Adaptive speed and NACK timeouts. */
+
+#include "host/LumpHost.h"
+
+#include "LumpTest.h"
+
+using LumpHost::HostEmulator;
+using LumpHost::MockSerial;
+using LumpTest::runUntil;
+
+static const LumpMode modes[]{
+    {"Analog", DATA16, 1, 4, 0},
+};
+
+TEST(unplugKeepsSpeed) {
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, LUMP_UART_SPEED_MAX, modes, 1);
+  device.setAdaptiveSpeed(true);
+  device.begin();
+
+  for (uint32_t i = 1; i <= 3; ++i) {
+    REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 5000000));
+
+    /* The host goes silent, as if the device had been unplugged. */
+    host.keepAlive = false;
+    REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Reset; }, 2000000));
+    host.keepAlive = true;
+  }
+
+  CHECK(device.linkStats().nackTimeouts == 3);
+  CHECK(device.speedDowngradeCount() == 0);
+  CHECK(device.currentSpeed() == LUMP_UART_SPEED_MAX);
+}
+
+TEST(garbledLinkLowersSpeed) {
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, LUMP_UART_SPEED_MAX, modes, 1);
+  device.setAdaptiveSpeed(true);
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 5000000));
+
+  /* Only garbled bytes arrive after the last NACK, as if the host could not keep up with the speed. */
+  host.keepAlive = false;
+  runUntil(device, host, [&] { return false; }, 500000);
+  const uint8_t garbled[] = {0xc4, 0x11, 0x22, 0x00};
+  serial.hostWrite(garbled, sizeof(garbled));
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Reset; }, 2000000));
+
+  CHECK(device.linkStats().checksumErrors == 1);
+  CHECK(device.speedDowngradeCount() == 1);
+  CHECK(device.currentSpeed() < LUMP_UART_SPEED_MAX);
+}
+
+TEST(errorsBeforeLastNackKeepSpeed) {
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, LUMP_UART_SPEED_MAX, modes, 1);
+  device.setAdaptiveSpeed(true);
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 5000000));
+
+  /* A glitch, then more keep-alive NACKs, then silence. */
+  const uint8_t garbled[] = {0xc4, 0x11, 0x22, 0x00};
+  serial.hostWrite(garbled, sizeof(garbled));
+  runUntil(device, host, [&] { return false; }, 300000);
+  host.keepAlive = false;
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Reset; }, 2000000));
+
+  CHECK(device.linkStats().checksumErrors == 1);
+  CHECK(device.speedDowngradeCount() == 0);
+}
@@ -0,0 +1,116 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/* Interrupt-fed RX ring, fed by a producer thread. Built with `LUMP_RX_RING_SIZE=256`. */
+
+#include "host/LumpHost.h"
+
+#include "LumpTest.h"
+#include <atomic>
+#include <thread>
+
+using LumpHost::HostEmulator;
+using LumpHost::MockSerial;
+
+static const LumpMode modes[]{
+    {"A", DATA32, 1, 4, 0},
+};
+
+TEST(ringStress) {
+  static LumpDeviceBuilder::Internal::SpscRing<256> ring;
+  const uint32_t numBytes = 4000000;
+
+  std::thread producer([&] {
+    for (uint32_t i = 0; i < numBytes;) {
+      if (ring.push(static_cast<uint8_t>(i * 7))) {
+        ++i;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  uint32_t errors = 0;
+  for (uint32_t i = 0; i < numBytes;) {
+    if (!ring.available()) {
+      std::this_thread::yield();
+      continue;
+    }
+    errors += ring.pop() != static_cast<uint8_t>(i * 7);
+    ++i;
+  }
+  producer.join();
+
+  CHECK(errors == 0);
+  CHECK(ring.available() == 0);
+  CHECK(ring.highWater <= 256);
+}
+
+static std::atomic<uint32_t> received{0};
+static std::atomic<uint32_t> badPayloads{0};
+
+static void onData(uint8_t mode, const uint8_t *data, uint8_t size) {
+  uint32_t seq;
+  memcpy(&seq, data, sizeof(seq));
+  if (mode != 0 || size != 4 || seq != received.load()) {
+    ++badPayloads;
+  }
+  ++received;
+}
+
+TEST(deviceStress) {
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 115200, modes, 1);
+  device.setDataCallback(onData);
+  device.begin();
+
+  /* Handshake through the ring, fed from the UART. */
+  REQUIRE(LumpTest::runUntil(device, host, [&] {
+    device.pumpRx();
+    return device.state() == LumpDeviceState::Communicating;
+  }, 5000000));
+
+  /**
+   * The producer thread stands in for the RX interrupt and pushes data messages while `run()` parses them.
+   * The clock stands still, so the NACK timeout cannot expire. At most 16 messages (96 bytes) are in flight.
+   */
+  const uint32_t numMsgs = 200000;
+  std::thread producer([&] {
+    for (uint32_t seq = 0; seq < numMsgs; ++seq) {
+      while (seq - received.load() >= 16) {
+        std::this_thread::yield();
+      }
+      uint8_t msg[6]{LUMP_MSG_TYPE_DATA | (2 << 3)};
+      memcpy(&msg[1], &seq, sizeof(seq));
+      msg[5] = LumpHost::checksum(msg, 5);
+      for (uint8_t c : msg) {
+        device.pushRxByte(c);
+      }
+    }
+  });
+
+  while (received.load() < numMsgs) {
+    device.run();
+    std::this_thread::yield();
+  }
+  producer.join();
+
+  CHECK(badPayloads.load() == 0);
+  CHECK(device.rxRingOverflowCount() == 0);
+  CHECK(device.rxRingHighWater() <= 96);
+  CHECK(device.state() == LumpDeviceState::Communicating);
+}
+
+TEST(overflow) {
+  MockSerial serial;
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 115200, modes, 1);
+
+  for (int i = 0; i < 300; ++i) {
+    device.pushRxByte(LUMP_SYS_NACK);
+  }
+
+  CHECK(device.rxRingOverflowCount() == 44);
+  CHECK(device.rxRingHighWater() == 256);
+}
@@ -0,0 +1,78 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/* Streaming schedules. */
+
+#include "host/LumpHost.h"
+
+#include "LumpTest.h"
+
+using LumpHost::HostEmulator;
+using LumpHost::MockSerial;
+using LumpTest::runUntil;
+
+static const LumpMode modes[]{
+    {"A", DATA16, 1, 4, 0},
+};
+
+static uint32_t samples[2];
+
+static bool sample(uint8_t mode, void *data) {
+  ++samples[mode];
+  return true;
+}
+
+/* One schedule more than there are modes. */
+static const LumpModeSchedule schedules[]{
+    {sample, 10000},
+    {sample, 10000},
+};
+
+TEST(extraSchedulesAreIgnored) {
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 115200, modes, 1);
+  device.setSchedules(schedules, 2);
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 5000000));
+  REQUIRE(runUntil(device, host, [&] { return samples[0] > 0; }, 100000));
+
+  /* Mode 1 does not exist: its schedule must not run with `modes[1]`. */
+  host.selectMode(1);
+  runUntil(device, host, [&] { return false; }, 100000);
+  CHECK(samples[1] == 0);
+}
+
+TEST(abandonedReserveDoesNotStopSchedule) {
+  samples[0] = 0;
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 115200, modes, 1);
+  device.setSchedules(schedules, 1);
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 5000000));
+  REQUIRE(runUntil(device, host, [&] { return samples[0] > 0; }, 100000));
+
+  /* A reserved payload pauses the schedule until it is committed. */
+  REQUIRE(device.reserve<int16_t>() != nullptr);
+  runUntil(device, host, [&] { return false; }, 20000);
+  uint32_t paused = samples[0];
+  runUntil(device, host, [&] { return false; }, 50000);
+  CHECK(samples[0] == paused);
+
+  /* Selecting a mode discards the reservation. */
+  host.selectMode(0);
+  CHECK(runUntil(device, host, [&] { return samples[0] > paused; }, 100000));
+
+  /* So does a reconnect. */
+  REQUIRE(device.reserve<int16_t>() != nullptr);
+  host.keepAlive = false;
+  REQUIRE(runUntil(device, host, [&] { return device.state() != LumpDeviceState::Communicating; }, 5000000));
+  host.keepAlive = true;
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 10000000));
+  paused = samples[0];
+  CHECK(runUntil(device, host, [&] { return samples[0] > paused; }, 100000));
+}
@@ -0,0 +1,63 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/* Compile-time data formats. Built with debug output (`LUMP_DEBUG_SERIAL`). */
+
+#include "host/LumpHost.h"
+
+#include "LumpTest.h"
+
+using LumpHost::debugLog;
+using LumpHost::HostEmulator;
+using LumpHost::MockSerial;
+using LumpTest::runUntil;
+
+using Data16x3 = LumpDataFormat<DATA16, 3>;
+using Data32x8 = LumpDataFormat<DATA32, 8>;
+
+static_assert(Data16x3::payloadSize == 6 && Data16x3::msgSize == 8, "DATA16 x 3 is padded to 8 bytes");
+static_assert(Data32x8::payloadSize == 32 && Data32x8::msgSize == 32, "DATA32 x 8 fills a message");
+
+static const LumpMode modes[]{
+    {"A", DATA16, 2, 4, 0},
+    {"B", DATA16, 3, 4, 0},
+};
+
+TEST(matchingFormat) {
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 115200, modes, 2);
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 5000000));
+
+  int16_t data[]{0x0102, 0x0304, 0x0506};
+  size_t numFrames = host.dataFrames.size();
+  device.sendAs<Data16x3>(data, 1);
+  REQUIRE(runUntil(device, host, [&] { return host.dataFrames.size() > numFrames; }, 10000));
+
+  const std::vector<uint8_t> expected{0x02, 0x01, 0x04, 0x03, 0x06, 0x05, 0x00, 0x00};
+  auto &bytes = host.dataFrames.back().bytes;
+  CHECK(host.dataFrames.back().cmd() == 1);
+  CHECK(std::vector<uint8_t>(bytes.begin() + 1, bytes.end() - 1) == expected);
+}
+
+TEST(mismatchedFormatIsDropped) {
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 115200, modes, 2);
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 5000000));
+
+  /* Mode 0 has 2 values, not 3. */
+  int16_t data[]{1, 2, 3};
+  size_t numFrames = host.dataFrames.size();
+  debugLog().text.clear();
+  device.sendAs<Data16x3>(data, 0);
+  runUntil(device, host, [&] { return false; }, 10000);
+
+  CHECK(host.dataFrames.size() == numFrames);
+  CHECK(debugLog().contains("[Error] Data format does not match mode: 0"));
+}
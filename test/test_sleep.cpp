@@ -0,0 +1,100 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * Sleeping between deadlines.
+ *
+ * The loop only calls `run()` and `sleep()`. Each loop iteration costs `busyMicros` of CPU time; otherwise the
+ * virtual clock only moves in the sleep callback, which returns when the time has elapsed or a byte is received,
+ * like `WFI` with a UART RX interrupt. The host keeps running while the device sleeps.
+ */
+
+#include "host/LumpHost.h"
+
+#include "LumpTest.h"
+
+using LumpHost::advance;
+using LumpHost::HostEmulator;
+using LumpHost::MockSerial;
+
+static const LumpMode modes[]{
+    {"A", DATA16, 1, 4, 0},
+};
+
+static bool sample(uint8_t mode, void *data) {
+  *static_cast<int16_t *>(data) = 1;
+  return true;
+}
+
+static const uint32_t period = 2500;
+static const LumpModeSchedule schedules[]{
+    {sample, period},
+};
+
+static const uint64_t busyMicros = 5;
+static MockSerial *serial;
+static HostEmulator *host;
+static uint64_t sleptMicros;
+
+static void sleepFor(uint32_t us) {
+  uint64_t end = LumpHost::clock().load() + us;
+  while (LumpHost::clock().load() < end && !serial->available()) {
+    uint64_t step = std::min<uint64_t>(end - LumpHost::clock().load(), 100);
+    advance(step);
+    sleptMicros += step;
+    host->step();
+  }
+}
+
+TEST(deadlinesAreKept) {
+  MockSerial s;
+  HostEmulator h(s);
+  serial = &s;
+  host   = &h;
+
+  LumpDevice<MockSerial> device(&s, 1, 2, 68, 115200, modes, 1);
+  device.setSchedules(schedules, 1);
+  device.setSleepCallback(sleepFor);
+  device.begin();
+
+  auto loop = [&] {
+    h.step();
+    device.run();
+    device.sleep();
+    advance(busyMicros);
+  };
+
+  while (!h.connected && LumpHost::clock().load() < 5000000) {
+    loop();
+  }
+  REQUIRE(h.connected);
+
+  /* Skips the first data messages, sent right after the handshake. */
+  uint64_t start = LumpHost::clock().load() + 10000;
+  while (LumpHost::clock().load() < start) {
+    loop();
+  }
+  size_t first = h.dataFrames.size();
+  sleptMicros  = 0;
+
+  while (LumpHost::clock().load() < start + 2000000) {
+    loop();
+  }
+
+  uint64_t maxGap = 0;
+  uint64_t minGap = UINT64_MAX;
+  for (size_t i = first + 1; i < h.dataFrames.size(); ++i) {
+    uint64_t gap = h.dataFrames[i].micros - h.dataFrames[i - 1].micros;
+    maxGap       = std::max(maxGap, gap);
+    minGap       = std::min(minGap, gap);
+  }
+  double sleepRatio = static_cast<double>(sleptMicros) / 2000000;
+  printf("data messages: %zu, gap: %llu..%llu us, sleep ratio: %.3f\n", h.dataFrames.size() - first,
+         static_cast<unsigned long long>(minGap), static_cast<unsigned long long>(maxGap), sleepRatio);
+
+  CHECK(h.connected && h.handshakes == 1);
+  CHECK(h.dataFrames.size() - first >= 2000000 / period - 1);
+  CHECK(maxGap <= period + busyMicros);
+  CHECK(sleepRatio > 0.95);
+}
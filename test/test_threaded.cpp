@@ -0,0 +1,93 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/* Threaded runner, with the protocol task on a `std::thread`. Built with `LUMP_THREADED_RUNNER=1`. */
+
+#include <thread>
+#define LUMP_TASK_YIELD() std::this_thread::yield()
+
+#include "host/LumpHost.h"
+
+#include "LumpTest.h"
+
+using LumpHost::HostEmulator;
+using LumpHost::MockSerial;
+
+static const LumpMode modes[]{
+    {"A", DATA32, 4, 4, 0},
+};
+
+/**
+ * Runs the host and publishes samples from this thread until the host has received `numFrames` more data messages.
+ * Every sample holds its sequence number four times, so a torn sample has different values.
+ */
+static bool publishUntil(LumpDevice<MockSerial> &device, HostEmulator &host, uint32_t &seq, size_t numFrames) {
+  size_t end = host.dataFrames.size() + numFrames;
+  for (uint32_t i = 0; i < 10000000 && host.dataFrames.size() < end; ++i) {
+    host.step();
+    if (device.state() == LumpDeviceState::Communicating && device.mode() == 0) {
+      int32_t data[4]{static_cast<int32_t>(seq), static_cast<int32_t>(seq), static_cast<int32_t>(seq),
+                      static_cast<int32_t>(seq)};
+      device.publish(data, 4, 0);
+      ++seq;
+    }
+    LumpHost::advance(100);
+    std::this_thread::yield();
+  }
+  return host.dataFrames.size() >= end;
+}
+
+/* Checks that the samples received by the host are whole and in order. */
+static bool samplesInOrder(const HostEmulator &host) {
+  int32_t prev = -1;
+  for (const auto &frame : host.dataFrames) {
+    int32_t v[4];
+    memcpy(v, &frame.bytes[1], sizeof(v));
+    if (v[0] != v[1] || v[0] != v[2] || v[0] != v[3] || v[0] <= prev) {
+      return false;
+    }
+    prev = v[0];
+  }
+  return true;
+}
+
+TEST(publishStress) {
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 115200, modes, 1);
+  device.begin();
+
+  std::thread task(LumpDevice<MockSerial>::protocolTask, &device);
+  uint32_t seq = 0;
+  bool done    = publishUntil(device, host, seq, 20000);
+  device.stopProtocolTask();
+  task.join();
+
+  REQUIRE(done);
+  CHECK(host.handshakes == 1);
+  CHECK(host.badChecksums == 0);
+  CHECK(samplesInOrder(host));
+}
+
+TEST(restartTask) {
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 115200, modes, 1);
+  device.begin();
+
+  uint32_t seq = 0;
+  std::thread task(LumpDevice<MockSerial>::protocolTask, &device);
+  REQUIRE(publishUntil(device, host, seq, 10));
+  device.stopProtocolTask();
+  task.join();
+
+  /* A stopped task starts again. */
+  task = std::thread(LumpDevice<MockSerial>::protocolTask, &device);
+  bool done = publishUntil(device, host, seq, 10);
+  device.stopProtocolTask();
+  task.join();
+
+  CHECK(done);
+  CHECK(samplesInOrder(host));
+}
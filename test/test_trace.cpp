@@ -0,0 +1,116 @@
+// SPDX-FileCopyrightText: 2023-2025 OFDL Robotics Lab
+// SPDX-FileCopyrightText: 2023-2025 HsiangYi Tsai <devilhyt@gmail.com>
+// SPDX-License-Identifier: MIT
+
+/* Binary tracer. Built with `LUMP_TRACE_SIZE=64`. */
+
+#include "host/LumpHost.h"
+
+#include "LumpTest.h"
+
+using LumpHost::HostEmulator;
+using LumpHost::MockSerial;
+using LumpTest::runUntil;
+
+static const LumpMode modes[]{
+    {"A", DATA16, 1, 4, 0},
+};
+
+TEST(checksumError) {
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 115200, modes, 1);
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 5000000));
+
+  LumpTraceRecord records[64];
+  while (device.readTrace(records, 64)) {
+  }
+
+  /* 2-byte DATA message for mode 0 with the checksum 0x00 instead of 0x04. */
+  const uint8_t msg[]{0xc8, 0x11, 0x22, 0x00};
+  serial.hostWrite(msg, sizeof(msg));
+  runUntil(device, host, [&] { return false; }, 1000);
+
+  uint16_t num = device.readTrace(records, 64);
+  int found    = -1;
+  for (uint16_t i = 0; i < num; ++i) {
+    if (records[i].event == LumpTraceEvent::ChecksumError) {
+      found = i;
+    }
+  }
+  REQUIRE(found >= 0);
+  CHECK(records[found].arg == LumpHost::checksum(msg, 3));
+  CHECK(records[found].data[0] == 0x00);
+}
+
+static constexpr LumpMode wideModes[]{
+    {"W0", DATA32, 8, 4, 0},
+    {"W1", DATA32, 8, 4, 0},
+};
+
+TEST(droppedDataIsNotTracedAsSent) {
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 115200, wideModes, 2);
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 5000000));
+
+  LumpTraceRecord records[64];
+  while (device.readTrace(records, 64)) {
+  }
+
+  /* 34-byte data messages of alternating modes, faster than the TX queue can take them. */
+  int32_t data[8]{};
+  for (uint8_t i = 0; i < 6; ++i) {
+    device.send(data, 8, i % 2);
+  }
+  REQUIRE(device.txDropCount() > 0);
+
+  uint16_t num      = device.readTrace(records, 64);
+  uint32_t txFrames = 0;
+  uint32_t txDrops  = 0;
+  for (uint16_t i = 0; i < num; ++i) {
+    if (records[i].event == LumpTraceEvent::TxFrame && (records[i].data[0] & 0xc0) == LUMP_MSG_TYPE_DATA) {
+      ++txFrames;
+    } else if (records[i].event == LumpTraceEvent::TxDrop) {
+      ++txDrops;
+    }
+  }
+  CHECK(txDrops == device.txDropCount());
+  CHECK(txFrames == 6 - device.txDropCount() - device.txCoalesceCount());
+}
+
+TEST(handshakeImageIsTracedPerMessage) {
+  MockSerial serial;
+  HostEmulator host(serial);
+  LumpDevice<MockSerial> device(&serial, 1, 2, 68, 115200, modes, 1);
+  static uint8_t image[LUMP_HANDSHAKE_IMAGE_SIZE(1)];
+  device.setHandshakeImage(image, sizeof(image));
+  device.begin();
+
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 5000000));
+  host.keepAlive = false;
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Reset; }, 2000000));
+  host.keepAlive = true;
+
+  LumpTraceRecord records[64];
+  while (device.readTrace(records, 64)) {
+  }
+
+  /* The second handshake is streamed from the image. */
+  REQUIRE(runUntil(device, host, [&] { return device.state() == LumpDeviceState::Communicating; }, 5000000));
+
+  uint16_t num      = device.readTrace(records, 64);
+  uint32_t txFrames = 0;
+  for (uint16_t i = 0; i < num; ++i) {
+    if (records[i].event == LumpTraceEvent::TxFrame && (records[i].data[0] & 0xc0) != LUMP_MSG_TYPE_SYS) {
+      CHECK(records[i].arg == LumpHost::messageSize(records[i].data[0]));
+      ++txFrames;
+    }
+  }
+  CHECK(device.traceLostCount() == 0);
+  CHECK(txFrames == host.handshakeFrames.size());
+}